@@ -1,12 +1,50 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QSettings>
+
+#include <memory>
 
 #include "src/rendering/Window.hpp"
 
 int main(int argc, char *argv[])
 {
 	QApplication app(argc, argv);
+	QApplication::setOrganizationName("SMRayTracingRenderer");
+	QApplication::setApplicationName("SMRayTracingRenderer");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Sphere mesh renderer");
+	parser.addHelpOption();
+	parser.addPositionalArgument("mesh", "Sphere mesh to open (.sm, or .smb for a static mesh).");
+	const QCommandLineOption configOption({ "c", "config" }, "Read settings from an INI <file>.", "file");
+	parser.addOption(configOption);
+	const QCommandLineOption propOption({ "p", "prop" }, "Import a triangle mesh <file> into the scene (repeatable).",
+										"file");
+	parser.addOption(propOption);
+	const QCommandLineOption timingsOption({ "t", "timings" }, "Log per-stage frame timings to a CSV <file>.", "file");
+	parser.addOption(timingsOption);
+	parser.process(app);
+
+	// The command line wins over mesh/path, scene/props and profiling/csv in the config
+	const auto settings = parser.isSet(configOption)
+		? std::make_unique<QSettings>(parser.value(configOption), QSettings::IniFormat)
+		: std::make_unique<QSettings>();
+
+	QString meshPath = parser.positionalArguments().value(0);
+	if (meshPath.isEmpty())
+		meshPath = settings->value("mesh/path").toString();
+
+	QStringList propPaths = parser.values(propOption);
+	if (propPaths.isEmpty())
+		propPaths = settings->value("scene/props").toStringList();
+
+	const QString timingsPath = parser.isSet(timingsOption)
+		? parser.value(timingsOption)
+		: settings->value("profiling/csv").toString();
 
-	Window w;
+	Window w(meshPath, propPaths);
+	if (!timingsPath.isEmpty())
+		w.logFrameTimings(timingsPath);
 	w.show();
 
 	return QApplication::exec();
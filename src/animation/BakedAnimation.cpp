@@ -0,0 +1,231 @@
+#include "BakedAnimation.hpp"
+
+#include <QDebug>
+#include <QSaveFile>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstring>
+
+// Files are written in host order and documented as little-endian
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "baked animations assume a little-endian host");
+
+namespace
+{
+    constexpr char MAGIC[4] = { 'S', 'M', 'B', 'K' };
+    constexpr uint32_t VERSION = 1;
+
+    uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // count elements of size bytes starting at offset lie within limit, without overflowing
+    bool fits(const uint64_t offset, const uint64_t count, const uint64_t size, const uint64_t limit)
+    {
+        return offset <= limit && (size == 0 || count <= (limit - offset) / size);
+    }
+
+    bool writePadding(QSaveFile &file, const uint64_t target)
+    {
+        static const char zeros[SphereSoA::ALIGNMENT] = {};
+        const qint64 missing = static_cast<qint64>(target) - file.pos();
+        return missing <= 0 || file.write(zeros, missing) == missing;
+    }
+}
+
+BakedAnimation::~BakedAnimation()
+{
+    close();
+}
+
+std::vector<Pose> BakedAnimation::grid(const Pose &min, const Pose &max, const int alphaSteps, const int betaSteps)
+{
+    std::vector<Pose> poses;
+    poses.reserve(static_cast<size_t>(std::max(alphaSteps, 1)) * std::max(betaSteps, 1));
+
+    for (int b = 0; b < std::max(betaSteps, 1); b++)
+    {
+        const float tb = betaSteps > 1 ? static_cast<float>(b) / static_cast<float>(betaSteps - 1) : 0.0f;
+        for (int a = 0; a < std::max(alphaSteps, 1); a++)
+        {
+            const float ta = alphaSteps > 1 ? static_cast<float>(a) / static_cast<float>(alphaSteps - 1) : 0.0f;
+            poses.push_back({ min.alpha + (max.alpha - min.alpha) * ta,
+                              min.beta + (max.beta - min.beta) * tb });
+        }
+    }
+
+    return poses;
+}
+
+bool BakedAnimation::bake(PoseBatchEvaluator &evaluator, const std::vector<Pose> &poses,
+                          const QString &path, const size_t batchSize)
+{
+    // Written aside and renamed into place on commit: truncating the file in place would pull the
+    // pages from under anyone who has the old animation mapped, including this process
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Cannot write baked animation:" << path << file.errorString();
+        return false;
+    }
+
+    const size_t sphereCount = evaluator.source().sphere.size();
+    const size_t paddedCount = (sphereCount + SphereSoA::LANES - 1) / SphereSoA::LANES * SphereSoA::LANES;
+
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sphereCount = static_cast<uint32_t>(sphereCount);
+    header.paddedCount = static_cast<uint32_t>(paddedCount);
+    header.frameCount = poses.size();
+    header.poseTableOffset = sizeof(Header);
+    header.frameDataOffset = alignUp(header.poseTableOffset + poses.size() * sizeof(Pose), SphereSoA::ALIGNMENT);
+    header.frameStride = 4 * paddedCount * sizeof(float);
+
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header);
+    ok = ok && file.write(reinterpret_cast<const char*>(poses.data()),
+                          static_cast<qint64>(poses.size() * sizeof(Pose))) ==
+               static_cast<qint64>(poses.size() * sizeof(Pose));
+    ok = ok && writePadding(file, header.frameDataOffset);
+
+    // Evaluate and write in batches so memory stays bounded by batchSize frames
+    std::vector<SphereSoA> frames;
+    for (size_t first = 0; ok && first < poses.size(); first += batchSize)
+    {
+        const size_t last = std::min(poses.size(), first + std::max<size_t>(batchSize, 1));
+        const std::vector<Pose> batch(poses.begin() + first, poses.begin() + last);
+        evaluator.evaluate(batch, frames);
+
+        for (const SphereSoA &soa : frames)
+            for (const SphereSoA::Array *component : { &soa.x, &soa.y, &soa.z, &soa.r })
+            {
+                const auto bytes = static_cast<qint64>(paddedCount * sizeof(float));
+                ok = ok && file.write(reinterpret_cast<const char*>(component->data()), bytes) == bytes;
+            }
+    }
+
+    if (!ok || !file.commit())
+    {
+        qDebug() << "Error while writing baked animation:" << path << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool BakedAnimation::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Cannot open baked animation:" << path << m_file.errorString();
+        return false;
+    }
+
+    if (m_file.size() < static_cast<qint64>(sizeof(Header)))
+    {
+        qDebug() << "Baked animation is truncated:" << path;
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_file.size());
+    if (!m_data)
+    {
+        qDebug() << "Cannot map baked animation:" << path << m_file.errorString();
+        close();
+        return false;
+    }
+
+    std::memcpy(&m_header, m_data, sizeof(Header));
+
+    if (std::memcmp(m_header.magic, MAGIC, sizeof(MAGIC)) != 0 || m_header.version != VERSION ||
+        !hasValidLayout(m_header, static_cast<uint64_t>(m_file.size())))
+    {
+        qDebug() << "Not a valid baked animation:" << path;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool BakedAnimation::hasValidLayout(const Header &header, const uint64_t fileSize)
+{
+    // Every field is untrusted: check each section against the file before multiplying anything out
+    const uint64_t minimumStride = 4 * static_cast<uint64_t>(header.paddedCount) * sizeof(float);
+    return header.paddedCount >= header.sphereCount &&
+           header.paddedCount % SphereSoA::LANES == 0 &&
+           header.frameStride >= minimumStride &&
+           header.frameStride % SphereSoA::ALIGNMENT == 0 &&
+           header.poseTableOffset >= sizeof(Header) &&
+           fits(header.poseTableOffset, header.frameCount, sizeof(Pose), header.frameDataOffset) &&
+           header.frameDataOffset % SphereSoA::ALIGNMENT == 0 &&
+           fits(header.frameDataOffset, header.frameCount, header.frameStride, fileSize);
+}
+
+void BakedAnimation::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_header = {};
+
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool BakedAnimation::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+size_t BakedAnimation::frameCount() const
+{
+    return m_header.frameCount;
+}
+
+size_t BakedAnimation::sphereCount() const
+{
+    return m_header.sphereCount;
+}
+
+BakedAnimation::FrameView BakedAnimation::frame(const size_t index) const
+{
+    const size_t padded = m_header.paddedCount;
+    const auto* block = reinterpret_cast<const float*>(
+        m_data + m_header.frameDataOffset + index * m_header.frameStride);
+
+    FrameView view {};
+    view.x = block;
+    view.y = block + padded;
+    view.z = block + 2 * padded;
+    view.r = block + 3 * padded;
+    view.count = m_header.sphereCount;
+    std::memcpy(&view.pose, m_data + m_header.poseTableOffset + index * sizeof(Pose), sizeof(Pose));
+    return view;
+}
+
+void BakedAnimation::copyFrame(const size_t index, std::vector<SM::Sphere> &spheres, SphereSoA &soa) const
+{
+    const FrameView view = frame(index);
+
+    spheres.resize(view.count);
+    if (soa.size() != view.count)
+        soa.resize(view.count);
+
+    for (size_t i = 0; i < view.count; i++)
+    {
+        spheres[i].center = glm::vec3(view.x[i], view.y[i], view.z[i]);
+        spheres[i].radius = view.r[i];
+    }
+
+    const size_t bytes = view.count * sizeof(float);
+    std::memcpy(soa.x.data(), view.x, bytes);
+    std::memcpy(soa.y.data(), view.y, bytes);
+    std::memcpy(soa.z.data(), view.z, bytes);
+    std::memcpy(soa.r.data(), view.r, bytes);
+}
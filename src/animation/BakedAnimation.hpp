@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+#include "Pose.hpp"
+#include "PoseBatchEvaluator.hpp"
+#include "sphere_mesh.h"
+#include "../geometry/SphereSoA.hpp"
+
+/**
+ * @brief Pre-evaluated sphere positions for a sequence of poses, stored in a
+ *        memory-mapped file.
+ *
+ * The file holds a fixed header, the pose of every frame, then one block per
+ * frame with the x, y, z and r arrays laid out exactly like SphereSoA
+ * (64-byte aligned, padded to SphereSoA::LANES). Frames are read straight from
+ * the mapping, so playback never runs applyPose and every process opening the
+ * same file shares the page cache.
+ */
+class BakedAnimation
+{
+public:
+	struct FrameView {
+		const float* x;
+		const float* y;
+		const float* z;
+		const float* r;
+		size_t count;
+		Pose pose;
+	};
+
+	BakedAnimation() = default;
+	~BakedAnimation();
+
+	BakedAnimation(const BakedAnimation &) = delete;
+	BakedAnimation &operator=(const BakedAnimation &) = delete;
+
+	static std::vector<Pose> grid(const Pose &min, const Pose &max, int alphaSteps, int betaSteps);
+
+	// Replaces path atomically, so existing mappings of it keep reading the previous file
+	static bool bake(PoseBatchEvaluator &evaluator, const std::vector<Pose> &poses,
+					 const QString &path, size_t batchSize = 64);
+
+	bool open(const QString &path);
+	void close();
+	bool isOpen() const;
+
+	size_t frameCount() const;
+	size_t sphereCount() const;
+
+	FrameView frame(size_t index) const;
+	void copyFrame(size_t index, std::vector<SM::Sphere> &spheres, SphereSoA &soa) const;
+
+private:
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t sphereCount;
+		uint32_t paddedCount;
+		uint64_t frameCount;
+		uint64_t poseTableOffset;
+		uint64_t frameDataOffset;
+		uint64_t frameStride;
+		uint8_t reserved[16];
+	};
+	static_assert(sizeof(Header) == 64, "baked animation header must stay 64 bytes");
+
+	static bool hasValidLayout(const Header &header, uint64_t fileSize);
+
+	QFile m_file;
+	const uchar* m_data = nullptr;
+	Header m_header {};
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * @brief Blend-shape pose parameters, as passed to BumperGraph::setPose.
+ */
+struct Pose
+{
+	float alpha = 0.0f;
+	float beta = 0.0f;
+};
@@ -0,0 +1,42 @@
+#include "PoseBatchEvaluator.hpp"
+
+#include <algorithm>
+
+using namespace SM::Graph;
+
+PoseBatchEvaluator::PoseBatchEvaluator(const BumperGraph &source, ThreadPool &pool)
+    : m_source(source)
+    , m_pool(pool)
+{
+}
+
+void PoseBatchEvaluator::evaluate(const std::vector<Pose> &poses, std::vector<SphereSoA> &out)
+{
+    out.resize(poses.size());
+    if (poses.empty())
+        return;
+
+    // One scratch graph per slot, kept across calls to reuse its storage
+    m_scratch.resize(m_pool.slotCount());
+
+    const size_t chunk = std::max<size_t>(1, poses.size() / (4 * m_pool.slotCount()));
+
+    m_pool.parallelFor(poses.size(), chunk, [&](const size_t begin, const size_t end, const size_t slot) {
+        BumperGraph &work = m_scratch[slot];
+
+        for (size_t i = begin; i < end; i++)
+        {
+            // Every pose starts from the source state
+            work = m_source;
+
+            work.setPose(poses[i].alpha, poses[i].beta);
+            work.applyPose();
+            out[i].assign(work.sphere);
+        }
+    });
+}
+
+const BumperGraph &PoseBatchEvaluator::source() const
+{
+    return m_source;
+}
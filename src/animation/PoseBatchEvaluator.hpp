@@ -0,0 +1,39 @@
+#pragma once
+
+#include "bumper_graph.h"
+#include "Pose.hpp"
+#include "../core/ThreadPool.hpp"
+#include "../geometry/SphereSoA.hpp"
+
+#include <vector>
+
+/**
+ * @brief Evaluates many poses of a bumper graph in parallel.
+ *
+ * The evaluator keeps its own copy of the graph taken at construction, and
+ * every pose is applied to a per-thread scratch copy reset from it, so the
+ * live graph is never touched and results do not depend on scheduling. Poses
+ * are interpreted like a single setPose() call on the copied state.
+ *
+ * Resetting costs one copy assignment of the whole graph per pose, blend
+ * shapes included: the library offers no way to reset its pose state apart
+ * from the graph, so resetting only the spheres would not be safe. The
+ * scratch graphs keep their storage across calls, so the copy allocates
+ * nothing once warm. smbench times it next to applyPose as "graph reset".
+ */
+class PoseBatchEvaluator
+{
+public:
+	explicit PoseBatchEvaluator(const SM::Graph::BumperGraph &source,
+								ThreadPool &pool = ThreadPool::global());
+
+	void evaluate(const std::vector<Pose> &poses, std::vector<SphereSoA> &out);
+
+	const SM::Graph::BumperGraph &source() const;
+
+private:
+	SM::Graph::BumperGraph m_source;
+	ThreadPool &m_pool;
+
+	std::vector<SM::Graph::BumperGraph> m_scratch;
+};
@@ -0,0 +1,177 @@
+#include "Timeline.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+Timeline::Timeline()
+    : m_timestep(1.0 / 30.0)
+{
+    m_stats.targetFps = 1.0 / m_timestep;
+}
+
+void Timeline::setKeyframes(std::vector<Keyframe> keyframes)
+{
+    m_keyframes = std::move(keyframes);
+    std::stable_sort(m_keyframes.begin(), m_keyframes.end(),
+                     [](const Keyframe &a, const Keyframe &b) { return a.time < b.time; });
+}
+
+void Timeline::addKeyframe(const double time, const Pose &pose)
+{
+    const auto it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+                                     [](const double t, const Keyframe &k) { return t < k.time; });
+    m_keyframes.insert(it, { time, pose });
+}
+
+const std::vector<Timeline::Keyframe> &Timeline::keyframes() const
+{
+    return m_keyframes;
+}
+
+void Timeline::clear()
+{
+    m_keyframes.clear();
+    stop();
+}
+
+void Timeline::setTimestep(const double seconds)
+{
+    m_timestep = std::max(1e-4, seconds);
+    m_stats.targetFps = 1.0 / m_timestep;
+}
+
+double Timeline::timestep() const
+{
+    return m_timestep;
+}
+
+void Timeline::setLooping(const bool looping)
+{
+    m_looping = looping;
+}
+
+bool Timeline::isLooping() const
+{
+    return m_looping;
+}
+
+void Timeline::play()
+{
+    if (m_keyframes.empty())
+        return;
+
+    m_playing = true;
+}
+
+void Timeline::pause()
+{
+    m_playing = false;
+}
+
+void Timeline::stop()
+{
+    m_playing = false;
+    m_time = 0.0;
+    m_accumulator = 0.0;
+}
+
+bool Timeline::isPlaying() const
+{
+    return m_playing;
+}
+
+void Timeline::seek(const double time)
+{
+    m_time = std::clamp(time, 0.0, duration());
+    m_accumulator = 0.0;
+}
+
+double Timeline::time() const
+{
+    return m_time;
+}
+
+double Timeline::duration() const
+{
+    return m_keyframes.empty() ? 0.0 : m_keyframes.back().time;
+}
+
+Pose Timeline::poseAt(const double time) const
+{
+    if (m_keyframes.empty())
+        return {};
+    if (time <= m_keyframes.front().time)
+        return m_keyframes.front().pose;
+    if (time >= m_keyframes.back().time)
+        return m_keyframes.back().pose;
+
+    const auto next = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+                                       [](const double t, const Keyframe &k) { return t < k.time; });
+    const auto prev = next - 1;
+
+    const double span = next->time - prev->time;
+    const auto t = static_cast<float>(span > 0.0 ? (time - prev->time) / span : 1.0);
+
+    return { prev->pose.alpha + (next->pose.alpha - prev->pose.alpha) * t,
+             prev->pose.beta + (next->pose.beta - prev->pose.beta) * t };
+}
+
+bool Timeline::advance(const double elapsedSeconds, Pose &pose)
+{
+    if (!m_playing)
+        return false;
+
+    m_windowTime += elapsedSeconds;
+    if (m_windowTime >= 1.0)
+    {
+        m_stats.achievedFps = static_cast<double>(m_windowFrames) / m_windowTime;
+        m_windowTime = 0.0;
+        m_windowFrames = 0;
+    }
+
+    m_accumulator += elapsedSeconds;
+    const auto due = static_cast<size_t>(std::floor(m_accumulator / m_timestep));
+    if (due == 0)
+        return false;
+
+    // Catch up with the wall clock in one go; intermediate steps are dropped
+    m_accumulator -= static_cast<double>(due) * m_timestep;
+    m_time += static_cast<double>(due) * m_timestep;
+    m_stats.steps += due;
+    m_stats.droppedSteps += due - 1;
+
+    const double end = duration();
+    if (m_time >= end)
+    {
+        if (m_looping && end > 0.0)
+            m_time = std::fmod(m_time, end);
+        else
+        {
+            m_time = end;
+            m_playing = false;
+        }
+    }
+
+    pose = poseAt(m_time);
+    return true;
+}
+
+void Timeline::framePresented()
+{
+    m_windowFrames++;
+    m_stats.presentedFrames++;
+}
+
+Timeline::Stats Timeline::stats() const
+{
+    return m_stats;
+}
+
+void Timeline::resetStats()
+{
+    const double target = m_stats.targetFps;
+    m_stats = {};
+    m_stats.targetFps = target;
+    m_windowTime = 0.0;
+    m_windowFrames = 0;
+}
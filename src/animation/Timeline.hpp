@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Pose.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Keyframed pose playback on a fixed simulation timestep.
+ *
+ * advance() is fed wall-clock time and moves the simulation clock in whole
+ * timesteps. When more than one step is due (the pipeline fell behind), only
+ * the newest step is emitted and the others are counted as dropped, so
+ * playback stays in real time instead of slowing down. Poses between keyframes
+ * are linearly interpolated.
+ */
+class Timeline
+{
+public:
+	struct Keyframe {
+		double time;
+		Pose pose;
+	};
+
+	struct Stats {
+		double targetFps = 0.0;
+		double achievedFps = 0.0;
+		size_t steps = 0;
+		size_t droppedSteps = 0;
+		size_t presentedFrames = 0;
+	};
+
+	Timeline();
+
+	void setKeyframes(std::vector<Keyframe> keyframes);
+	void addKeyframe(double time, const Pose &pose);
+	const std::vector<Keyframe> &keyframes() const;
+	void clear();
+
+	void setTimestep(double seconds);
+	double timestep() const;
+
+	void setLooping(bool looping);
+	bool isLooping() const;
+
+	void play();
+	void pause();
+	void stop();
+	bool isPlaying() const;
+
+	void seek(double time);
+	double time() const;
+	double duration() const;
+
+	Pose poseAt(double time) const;
+
+	bool advance(double elapsedSeconds, Pose &pose);
+	void framePresented();
+
+	Stats stats() const;
+	void resetStats();
+
+private:
+	std::vector<Keyframe> m_keyframes;
+
+	double m_timestep;
+	bool m_looping = true;
+	bool m_playing = false;
+
+	double m_time = 0.0;
+	double m_accumulator = 0.0;
+
+	// Achieved rate is measured over windows of about one second
+	double m_windowTime = 0.0;
+	size_t m_windowFrames = 0;
+	Stats m_stats;
+};
@@ -0,0 +1,137 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace
+{
+    thread_local size_t currentSlot = 0;
+}
+
+ThreadPool::ThreadPool(const size_t threads)
+{
+    const size_t count = std::max<size_t>(1, threads);
+    m_workers.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        m_workers.emplace_back([this, i] {
+            // Slot 0 is left to threads outside the pool
+            currentSlot = i + 1;
+            run();
+        });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto &worker : m_workers)
+        worker.join();
+}
+
+size_t ThreadPool::size() const
+{
+    return m_workers.size();
+}
+
+size_t ThreadPool::slotCount() const
+{
+    return m_workers.size() + 1;
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(packaged));
+    }
+    m_wake.notify_one();
+    return result;
+}
+
+void ThreadPool::parallelFor(const size_t count, size_t chunk,
+                             const std::function<void(size_t, size_t, size_t)> &body)
+{
+    if (count == 0)
+        return;
+
+    chunk = std::max<size_t>(1, chunk);
+    const size_t chunks = (count + chunk - 1) / chunk;
+
+    // Helpers may only start after we returned; they then find no chunk left
+    // and never touch body, but the counters must outlive this call
+    struct State {
+        std::atomic<size_t> next { 0 };
+        size_t remaining;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining = chunks;
+
+    auto drain = [state, count, chunk, chunks, &body] {
+        size_t index;
+        while ((index = state->next.fetch_add(1)) < chunks)
+        {
+            const size_t begin = index * chunk;
+            const size_t end = std::min(count, begin + chunk);
+
+            std::exception_ptr error;
+            try {
+                body(begin, end, currentSlot);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard lock(state->mutex);
+            if (error && !state->error)
+                state->error = error;
+            if (--state->remaining == 0)
+                state->done.notify_all();
+        }
+    };
+
+    const size_t helpers = std::min(chunks - 1, m_workers.size());
+    for (size_t i = 0; i < helpers; i++)
+        submit(drain);
+
+    drain();
+
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->remaining == 0; });
+
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+ThreadPool &ThreadPool::global()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run()
+{
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping && m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads.
+ *
+ * parallelFor() lets the calling thread take chunks as well, so it can safely
+ * be nested inside a task running on the pool. Its body receives a slot index
+ * in [0, slotCount()) that is unique among the chunks of one call running at
+ * the same time, to address per-thread scratch data.
+ */
+class ThreadPool
+{
+public:
+	explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	size_t size() const;
+	size_t slotCount() const;
+
+	std::future<void> submit(std::function<void()> task);
+
+	void parallelFor(size_t count, size_t chunk,
+					 const std::function<void(size_t begin, size_t end, size_t slot)> &body);
+
+	static ThreadPool &global();
+
+private:
+	std::vector<std::thread> m_workers;
+	std::deque<std::packaged_task<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_stopping = false;
+
+	void run();
+};
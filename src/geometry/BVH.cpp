@@ -0,0 +1,147 @@
+#include "BVH.hpp"
+
+#include <algorithm>
+
+void BVH::build(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs, const uint32_t leafSize)
+{
+    clear();
+    if (mins.empty())
+        return;
+
+    order.resize(mins.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    // A median split tree over n primitives never needs more than 2n nodes
+    nodes.reserve(2 * mins.size());
+    nodes.emplace_back();
+    nodes[0].first = 0;
+    nodes[0].count = static_cast<uint32_t>(mins.size());
+
+    subdivide(0, mins, maxs, std::max<uint32_t>(1, leafSize));
+}
+
+void BVH::clear()
+{
+    nodes.clear();
+    order.clear();
+}
+
+bool BVH::empty() const
+{
+    return nodes.empty();
+}
+
+size_t BVH::bytes() const
+{
+    return nodes.capacity() * sizeof(Node) + order.capacity() * sizeof(uint32_t);
+}
+
+bool BVH::isValid(const size_t primitiveCount) const
+{
+    if (nodes.empty())
+        return order.empty();
+
+    if (order.size() != primitiveCount)
+        return false;
+    for (const uint32_t p : order)
+        if (p >= primitiveCount)
+            return false;
+
+    // Parents come first, so every depth is final by the time its node is visited
+    std::vector<uint32_t> depth(nodes.size(), 0);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        const Node &node = nodes[i];
+        if (node.isLeaf())
+        {
+            if (node.first > order.size() || node.count > order.size() - node.first)
+                return false;
+            continue;
+        }
+
+        if (node.first <= i || node.first + 1 >= nodes.size() || depth[i] + 1 >= STACK_SIZE)
+            return false;
+        depth[node.first] = std::max(depth[node.first], depth[i] + 1);
+        depth[node.first + 1] = std::max(depth[node.first + 1], depth[i] + 1);
+    }
+
+    return true;
+}
+
+bool BVH::overlaps(const Node &node, const glm::vec3 &origin, const glm::vec3 &invDirection, const float tMax)
+{
+    float tNear = 0.0f;
+    float tFar = tMax;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float t0 = (node.min[axis] - origin[axis]) * invDirection[axis];
+        float t1 = (node.max[axis] - origin[axis]) * invDirection[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        tNear = std::max(tNear, t0);
+        tFar = std::min(tFar, t1);
+        if (tNear > tFar)
+            return false;
+    }
+
+    return true;
+}
+
+void BVH::subdivide(const uint32_t nodeIndex, const std::vector<glm::vec3> &mins,
+                    const std::vector<glm::vec3> &maxs, const uint32_t leafSize)
+{
+    const uint32_t first = nodes[nodeIndex].first;
+    const uint32_t count = nodes[nodeIndex].count;
+
+    glm::vec3 boundsMin = mins[order[first]];
+    glm::vec3 boundsMax = maxs[order[first]];
+    glm::vec3 centroidMin = (mins[order[first]] + maxs[order[first]]) * 0.5f;
+    glm::vec3 centroidMax = centroidMin;
+
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        const uint32_t p = order[i];
+        boundsMin = glm::min(boundsMin, mins[p]);
+        boundsMax = glm::max(boundsMax, maxs[p]);
+
+        const glm::vec3 centroid = (mins[p] + maxs[p]) * 0.5f;
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+
+    nodes[nodeIndex].min = boundsMin;
+    nodes[nodeIndex].max = boundsMax;
+
+    const glm::vec3 extent = centroidMax - centroidMin;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    // Coincident centroids cannot be separated, keep them in one leaf
+    if (count <= leafSize || extent[axis] <= 0.0f)
+        return;
+
+    const uint32_t half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [&](const uint32_t a, const uint32_t b) {
+                         return mins[a][axis] + maxs[a][axis] < mins[b][axis] + maxs[b][axis];
+                     });
+
+    const uint32_t left = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    nodes.emplace_back();
+
+    nodes[left].first = first;
+    nodes[left].count = half;
+    nodes[left + 1].first = first + half;
+    nodes[left + 1].count = count - half;
+
+    nodes[nodeIndex].first = left;
+    nodes[nodeIndex].count = 0;
+
+    subdivide(left, mins, maxs, leafSize);
+    subdivide(left + 1, mins, maxs, leafSize);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <vector>
+
+struct Ray
+{
+	glm::vec3 origin;
+	glm::vec3 direction;
+};
+
+// Sphere hits leave triangle at NONE, triangle hits leave sphere at NONE.
+// Scenes mixing characters and props report one of instance or prop, the other is NONE
+struct RayHit
+{
+	static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+	float t = std::numeric_limits<float>::infinity();
+	uint32_t sphere = 0;
+	uint32_t triangle = NONE;
+	uint32_t instance = 0;
+	uint32_t prop = NONE;
+};
+
+/**
+ * @brief Bounding volume hierarchy over a set of axis aligned boxes.
+ *
+ * Nodes are split at the median centroid along their widest axis. Leaves
+ * reference a contiguous run of order[], which lists primitive indices in leaf
+ * order; an inner node's children are stored next to each other at first.
+ */
+class BVH
+{
+public:
+	struct Node
+	{
+		glm::vec3 min;
+		uint32_t first = 0;
+		glm::vec3 max;
+		uint32_t count = 0;
+
+		bool isLeaf() const { return count > 0; }
+	};
+
+	// Deepest path traverse() can follow without overflowing its stack
+	static constexpr uint32_t STACK_SIZE = 64;
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> order;
+
+	void build(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs, uint32_t leafSize);
+	void clear();
+	bool empty() const;
+	size_t bytes() const;
+
+	// For hierarchies read from disk: every index in range, children stored after
+	// their parent and no path deeper than the traversal stack
+	bool isValid(size_t primitiveCount) const;
+
+	static bool overlaps(const Node &node, const glm::vec3 &origin, const glm::vec3 &invDirection, float tMax);
+
+	// Calls leaf(k, tMax) for every leaf-order position k whose primitive, order[k],
+	// the ray may hit before tMax; leaf can shorten tMax to prune the traversal.
+	template <typename Leaf>
+	void traverse(const Ray &ray, float &tMax, Leaf &&leaf) const
+	{
+		if (nodes.empty())
+			return;
+
+		const glm::vec3 invDirection = 1.0f / ray.direction;
+
+		uint32_t stack[STACK_SIZE];
+		size_t top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const Node &node = nodes[stack[--top]];
+			if (!overlaps(node, ray.origin, invDirection, tMax))
+				continue;
+
+			if (node.isLeaf())
+			{
+				for (uint32_t k = node.first; k < node.first + node.count; k++)
+					leaf(k, tMax);
+			}
+			else
+			{
+				stack[top++] = node.first + 1;
+				stack[top++] = node.first;
+			}
+		}
+	}
+
+private:
+	void subdivide(uint32_t nodeIndex, const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs,
+				   uint32_t leafSize);
+};
@@ -0,0 +1,31 @@
+#include "BumperBuckets.hpp"
+
+#include <type_traits>
+#include <variant>
+
+using namespace SM::Graph;
+
+BumperBuckets BumperBuckets::from(const BumperGraph &graph)
+{
+    BumperBuckets buckets;
+
+    for (const auto &b : graph.bumper)
+    {
+        std::visit([&buckets](const auto &shape) {
+            using T = std::decay_t<decltype(shape)>;
+            if constexpr (std::is_same_v<T, BumperPrysmoid>)
+                buckets.prysmoids.push_back(shape);
+            else if constexpr (std::is_same_v<T, BumperQuad>)
+                buckets.quads.push_back(shape);
+            else if constexpr (std::is_same_v<T, BumperCapsuloid>)
+                buckets.capsuloids.push_back(shape);
+        }, b.bumper);
+    }
+
+    return buckets;
+}
+
+size_t BumperBuckets::size() const
+{
+    return prysmoids.size() + quads.size() + capsuloids.size();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "bumper_graph.h"
+
+#include <vector>
+
+/**
+ * @brief Bumpers of a graph split into contiguous, type-homogeneous arrays.
+ *
+ * Bumper topology does not change after BumperGraph::constructFrom, so the
+ * buckets are filled once and the per-pose tessellation never has to inspect
+ * shapeType or the variant again.
+ */
+struct BumperBuckets
+{
+	std::vector<SM::Graph::BumperPrysmoid> prysmoids;
+	std::vector<SM::Graph::BumperQuad> quads;
+	std::vector<SM::Graph::BumperCapsuloid> capsuloids;
+
+	static BumperBuckets from(const SM::Graph::BumperGraph &graph);
+
+	size_t size() const;
+};
@@ -0,0 +1,30 @@
+#include "BumperGeometry.hpp"
+
+void BumperGeometry::clear()
+{
+    vertices.clear();
+    indices16.clear();
+    indices32.clear();
+    subMeshes.clear();
+}
+
+size_t BumperGeometry::indexCount() const
+{
+    return indices16.size() + indices32.size();
+}
+
+size_t BumperGeometry::vertexBytes() const
+{
+    return vertices.capacity() * sizeof(Vertex);
+}
+
+size_t BumperGeometry::indexBytes() const
+{
+    return indices16.capacity() * sizeof(uint16_t)
+         + indices32.capacity() * sizeof(uint32_t);
+}
+
+size_t BumperGeometry::cpuBytes() const
+{
+    return vertexBytes() + indexBytes() + subMeshes.capacity() * sizeof(SubMesh);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief CPU side triangle data of the tessellated bumpers for one pose.
+ *
+ * Every submesh indexes its own vertex range starting at baseVertex. Ranges
+ * that fit in 16 bits store their indices in indices16, larger ones in
+ * indices32; indexOffset counts elements of whichever array is used.
+ */
+struct BumperGeometry
+{
+	static constexpr size_t MAX_SHORT_VERTICES = 1u << 16;
+
+	struct Vertex {
+		glm::vec3 position;
+		glm::vec3 normal;
+	};
+
+	struct SubMesh {
+		size_t baseVertex;
+		size_t vertexCount;
+		size_t indexOffset;
+		size_t indexCount;
+		bool wideIndices;
+		glm::vec3 color;
+	};
+
+	std::vector<Vertex> vertices;
+	std::vector<uint16_t> indices16;
+	std::vector<uint32_t> indices32;
+	std::vector<SubMesh> subMeshes;
+
+	void clear();
+
+	size_t indexCount() const;
+
+	size_t vertexBytes() const;
+	size_t indexBytes() const;
+	size_t cpuBytes() const;
+};
@@ -0,0 +1,421 @@
+#include "BumperGeometryBuilder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+using namespace SM;
+using namespace SM::Graph;
+
+namespace
+{
+    constexpr int SEGMENTS = 32;
+
+    // Triangles emitted per bumper: 2 per capsule segment plus the cap faces
+    constexpr size_t CAPSULE_TRIANGLES = 2 * SEGMENTS;
+    constexpr size_t PRYSMOID_TRIANGLES = 2 + 3 * CAPSULE_TRIANGLES;
+    constexpr size_t QUAD_TRIANGLES = 4 + 4 * CAPSULE_TRIANGLES;
+
+    template <typename T>
+    constexpr size_t trianglesOf()
+    {
+        if constexpr (std::is_same_v<T, BumperPrysmoid>)
+            return PRYSMOID_TRIANGLES;
+        else if constexpr (std::is_same_v<T, BumperQuad>)
+            return QUAD_TRIANGLES;
+        else
+            return CAPSULE_TRIANGLES;
+    }
+}
+
+BumperGeometryBuilder::BumperGeometryBuilder(BumperBuckets buckets)
+    : m_buckets(std::move(buckets))
+{
+}
+
+const BumperBuckets &BumperGeometryBuilder::buckets() const
+{
+    return m_buckets;
+}
+
+void BumperGeometryBuilder::setMaxSubMeshVertices(const size_t count)
+{
+    m_maxSubMeshVertices = count;
+}
+
+size_t BumperGeometryBuilder::maxSubMeshVertices() const
+{
+    return m_maxSubMeshVertices;
+}
+
+template <typename T>
+void BumperGeometryBuilder::buildBucket(const std::vector<T> &bucket, const glm::vec3 &color)
+{
+    // Split the bucket so that each submesh stays within the vertex limit
+    constexpr size_t bumperVertices = 3 * trianglesOf<T>();
+    const size_t perSubMesh = m_maxSubMeshVertices == 0
+        ? bucket.size()
+        : std::max<size_t>(1, m_maxSubMeshVertices / bumperVertices);
+
+    for (size_t first = 0; first < bucket.size(); first += perSubMesh)
+    {
+        const size_t last = std::min(bucket.size(), first + perSubMesh);
+
+        beginSubMesh(color, (last - first) * bumperVertices);
+        for (size_t i = first; i < last; i++)
+            buildGeometry(bucket[i]);
+        endSubMesh();
+    }
+}
+
+void BumperGeometryBuilder::beginSubMesh(const glm::vec3 &color, const size_t vertexCount)
+{
+    m_sub.baseVertex = m_out->vertices.size();
+    m_sub.vertexCount = vertexCount;
+    m_sub.wideIndices = vertexCount > BumperGeometry::MAX_SHORT_VERTICES;
+    m_sub.indexOffset = m_sub.wideIndices ? m_out->indices32.size() : m_out->indices16.size();
+    m_sub.indexCount = 0;
+    m_sub.color = color;
+}
+
+void BumperGeometryBuilder::endSubMesh()
+{
+    const size_t indexEnd = m_sub.wideIndices ? m_out->indices32.size() : m_out->indices16.size();
+
+    m_sub.vertexCount = m_out->vertices.size() - m_sub.baseVertex;
+    m_sub.indexCount = indexEnd - m_sub.indexOffset;
+    m_out->subMeshes.push_back(m_sub);
+}
+
+void BumperGeometryBuilder::build(const std::vector<Sphere> &spheres, BumperGeometry &out)
+{
+    m_spheres = &spheres;
+    m_out = &out;
+    m_out->clear();
+
+    const size_t triangles = m_buckets.prysmoids.size() * PRYSMOID_TRIANGLES
+                           + m_buckets.quads.size() * QUAD_TRIANGLES
+                           + m_buckets.capsuloids.size() * CAPSULE_TRIANGLES;
+    m_out->vertices.reserve(3 * triangles);
+    if (m_maxSubMeshVertices != 0 && m_maxSubMeshVertices <= BumperGeometry::MAX_SHORT_VERTICES)
+        m_out->indices16.reserve(3 * triangles);
+
+    buildBucket(m_buckets.prysmoids, glm::vec3(0.8f, 0.5f, 0.3f));
+    buildBucket(m_buckets.quads, glm::vec3(0.8f, 0.3f, 0.5f));
+    buildBucket(m_buckets.capsuloids, glm::vec3(0.0f, 0.0f, 0.75f));
+
+    m_spheres = nullptr;
+    m_out = nullptr;
+}
+
+void BumperGeometryBuilder::rebuild(const std::vector<Sphere> &spheres, const std::vector<uint32_t> &dirtySpheres,
+                                    BumperGeometry &geometry)
+{
+    if (m_sphereBumperOffsets.size() != spheres.size() + 1)
+        buildAdjacency(spheres.size());
+
+    m_dirtyBumpers.clear();
+    for (const uint32_t sphere : dirtySpheres)
+        for (uint32_t k = m_sphereBumperOffsets[sphere]; k < m_sphereBumperOffsets[sphere + 1]; k++)
+        {
+            const uint32_t ordinal = m_sphereBumpers[k];
+            if (!m_bumperMarks[ordinal])
+            {
+                m_bumperMarks[ordinal] = 1;
+                m_dirtyBumpers.push_back(ordinal);
+            }
+        }
+
+    // Ascending order keeps the vertex writes sequential
+    std::sort(m_dirtyBumpers.begin(), m_dirtyBumpers.end());
+
+    m_spheres = &spheres;
+    m_out = &geometry;
+    m_patching = true;
+
+    for (const uint32_t ordinal : m_dirtyBumpers)
+    {
+        m_bumperMarks[ordinal] = 0;
+        m_cursor = firstVertexOf(ordinal);
+        rebuildBumper(ordinal);
+    }
+
+    m_patching = false;
+    m_spheres = nullptr;
+    m_out = nullptr;
+}
+
+void BumperGeometryBuilder::buildAdjacency(const size_t sphereCount)
+{
+    // Calls fn(ordinal, sphereIndex) for every sphere of every bumper, in bucket order
+    auto forEachIncidence = [this](auto &&fn) {
+        uint32_t ordinal = 0;
+        auto walk = [&](const auto &bucket) {
+            for (const auto &bumper : bucket)
+            {
+                for (const int sphere : bumper.sphereIndex)
+                    fn(ordinal, static_cast<uint32_t>(sphere));
+                ordinal++;
+            }
+        };
+        walk(m_buckets.prysmoids);
+        walk(m_buckets.quads);
+        walk(m_buckets.capsuloids);
+    };
+
+    m_sphereBumperOffsets.assign(sphereCount + 1, 0);
+    forEachIncidence([this](uint32_t, const uint32_t sphere) {
+        m_sphereBumperOffsets[sphere + 1]++;
+    });
+    for (size_t i = 0; i < sphereCount; i++)
+        m_sphereBumperOffsets[i + 1] += m_sphereBumperOffsets[i];
+
+    m_sphereBumpers.resize(m_sphereBumperOffsets[sphereCount]);
+    std::vector<uint32_t> fill(m_sphereBumperOffsets.begin(), m_sphereBumperOffsets.end() - 1);
+    forEachIncidence([this, &fill](const uint32_t ordinal, const uint32_t sphere) {
+        m_sphereBumpers[fill[sphere]++] = ordinal;
+    });
+
+    m_bumperMarks.assign(m_buckets.size(), 0);
+}
+
+size_t BumperGeometryBuilder::firstVertexOf(uint32_t ordinal) const
+{
+    // Every bumper of a type emits the same number of vertices, in bucket order
+    size_t base = 0;
+
+    if (ordinal < m_buckets.prysmoids.size())
+        return base + ordinal * 3 * PRYSMOID_TRIANGLES;
+    ordinal -= static_cast<uint32_t>(m_buckets.prysmoids.size());
+    base += m_buckets.prysmoids.size() * 3 * PRYSMOID_TRIANGLES;
+
+    if (ordinal < m_buckets.quads.size())
+        return base + ordinal * 3 * QUAD_TRIANGLES;
+    ordinal -= static_cast<uint32_t>(m_buckets.quads.size());
+    base += m_buckets.quads.size() * 3 * QUAD_TRIANGLES;
+
+    return base + ordinal * 3 * CAPSULE_TRIANGLES;
+}
+
+void BumperGeometryBuilder::rebuildBumper(uint32_t ordinal)
+{
+    if (ordinal < m_buckets.prysmoids.size())
+        return buildGeometry(m_buckets.prysmoids[ordinal]);
+    ordinal -= static_cast<uint32_t>(m_buckets.prysmoids.size());
+
+    if (ordinal < m_buckets.quads.size())
+        return buildGeometry(m_buckets.quads[ordinal]);
+    ordinal -= static_cast<uint32_t>(m_buckets.quads.size());
+
+    buildGeometry(m_buckets.capsuloids[ordinal]);
+}
+
+glm::vec3 BumperGeometryBuilder::computeUpperPlaneNormal(const Sphere &sa, const Sphere &sb, const Sphere &sc, const int direction)
+{
+    glm::vec3 a = sa.center;
+    glm::vec3 b = sb.center;
+    glm::vec3 c = sc.center;
+
+    const float sign = static_cast<float>(direction);
+
+    glm::vec3 n = sign * glm::normalize(glm::cross(b - a, c - a));
+    const glm::vec3 startN = n;
+
+    for (int i = 0; i < 1000; i++){
+        a = sa.center + n * sa.radius;
+        b = sb.center + n * sb.radius;
+        c = sc.center + n * sc.radius;
+
+        glm::vec3 new_n = glm::normalize(sign * glm::cross(b - a, c - a));
+        if (glm::dot(n, new_n) >= 0.999f)
+            if (glm::dot(startN, new_n) < 0)
+                return new_n;
+        n = new_n;
+    }
+
+    return n;
+}
+
+void BumperGeometryBuilder::buildGeometry(const BumperPrysmoid &bp)
+{
+    const Sphere &s0 = (*m_spheres)[bp.sphereIndex[0]];
+    const Sphere &s1 = (*m_spheres)[bp.sphereIndex[1]];
+    const Sphere &s2 = (*m_spheres)[bp.sphereIndex[2]];
+
+    glm::vec3 C1 = s0.center;
+    glm::vec3 C2 = s1.center;
+    glm::vec3 C3 = s2.center;
+
+    const float R1 = s0.radius;
+    const float R2 = s1.radius;
+    const float R3 = s2.radius;
+
+    glm::vec3 nTop    = computeUpperPlaneNormal(s0, s1, s2,  1);
+    glm::vec3 nBottom = computeUpperPlaneNormal(s0, s1, s2, -1);
+
+    glm::vec3 V1_top    = C1 + nTop * R1;
+    glm::vec3 V2_top    = C2 + nTop * R2;
+    glm::vec3 V3_top    = C3 + nTop * R3;
+    glm::vec3 V1_bottom = C1 + nBottom * R1;
+    glm::vec3 V2_bottom = C2 + nBottom * R2;
+    glm::vec3 V3_bottom = C3 + nBottom * R3;
+
+    appendTriangle(V1_top, V2_top, V3_top, nTop, nTop, nTop);
+    appendTriangle(V1_bottom, V2_bottom, V3_bottom, nBottom, nBottom, nBottom);
+
+    buildCapsuleBetweenSpheres(bp.sphereIndex[0], bp.sphereIndex[1]);
+    buildCapsuleBetweenSpheres(bp.sphereIndex[1], bp.sphereIndex[2]);
+    buildCapsuleBetweenSpheres(bp.sphereIndex[2], bp.sphereIndex[0]);
+}
+
+void BumperGeometryBuilder::appendTriangle(const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3,
+    const glm::vec3 &n1, const glm::vec3 &n2, const glm::vec3 &n3)
+{
+    auto &vertices = m_out->vertices;
+
+    if (m_patching)
+    {
+        vertices[m_cursor++] = BumperGeometry::Vertex{ p1, n1 };
+        vertices[m_cursor++] = BumperGeometry::Vertex{ p2, n2 };
+        vertices[m_cursor++] = BumperGeometry::Vertex{ p3, n3 };
+        return;
+    }
+
+    const size_t startIndex = vertices.size() - m_sub.baseVertex;
+
+    vertices.push_back(BumperGeometry::Vertex{ p1, n1 });
+    vertices.push_back(BumperGeometry::Vertex{ p2, n2 });
+    vertices.push_back(BumperGeometry::Vertex{ p3, n3 });
+
+    if (m_sub.wideIndices)
+    {
+        auto &indices = m_out->indices32;
+        indices.push_back(static_cast<uint32_t>(startIndex + 0));
+        indices.push_back(static_cast<uint32_t>(startIndex + 1));
+        indices.push_back(static_cast<uint32_t>(startIndex + 2));
+    }
+    else
+    {
+        auto &indices = m_out->indices16;
+        indices.push_back(static_cast<uint16_t>(startIndex + 0));
+        indices.push_back(static_cast<uint16_t>(startIndex + 1));
+        indices.push_back(static_cast<uint16_t>(startIndex + 2));
+    }
+}
+
+void BumperGeometryBuilder::buildGeometry(const BumperQuad &bq)
+{
+    const Sphere &s0 = (*m_spheres)[bq.sphereIndex[0]];
+    const Sphere &s1 = (*m_spheres)[bq.sphereIndex[1]];
+    const Sphere &s2 = (*m_spheres)[bq.sphereIndex[2]];
+    const Sphere &s3 = (*m_spheres)[bq.sphereIndex[3]];
+
+    glm::vec3 C1 = s0.center;
+    glm::vec3 C2 = s1.center;
+    glm::vec3 C3 = s2.center;
+    glm::vec3 C4 = s3.center;
+
+    const float R1 = s0.radius;
+    const float R2 = s1.radius;
+    const float R3 = s2.radius;
+    const float R4 = s3.radius;
+
+    glm::vec3 nTop    = computeUpperPlaneNormal(s0, s1, s2,  1);
+    glm::vec3 nBottom = computeUpperPlaneNormal(s0, s1, s2, -1);
+
+    glm::vec3 V1_top = C1 + nTop * R1;
+    glm::vec3 V2_top = C2 + nTop * R2;
+    glm::vec3 V3_top = C3 + nTop * R3;
+    glm::vec3 V4_top = C4 + nTop * R4;
+
+    glm::vec3 V1_bottom = C1 + nBottom * R1;
+    glm::vec3 V2_bottom = C2 + nBottom * R2;
+    glm::vec3 V3_bottom = C3 + nBottom * R3;
+    glm::vec3 V4_bottom = C4 + nBottom * R4;
+
+    appendTriangle(V1_top, V2_top, V3_top, nTop, nTop, nTop);
+    appendTriangle(V3_top, V4_top, V1_top, nTop, nTop, nTop);
+
+    appendTriangle(V1_bottom, V2_bottom, V3_bottom, nBottom, nBottom, nBottom);
+    appendTriangle(V3_bottom, V4_bottom, V1_bottom, nBottom, nBottom, nBottom);
+
+    buildCapsuleBetweenSpheres(bq.sphereIndex[0], bq.sphereIndex[1]);
+    buildCapsuleBetweenSpheres(bq.sphereIndex[1], bq.sphereIndex[2]);
+    buildCapsuleBetweenSpheres(bq.sphereIndex[2], bq.sphereIndex[3]);
+    buildCapsuleBetweenSpheres(bq.sphereIndex[3], bq.sphereIndex[0]);
+}
+
+void BumperGeometryBuilder::buildCapsuleBetweenSpheres(const int sphereIndex1, const int sphereIndex2)
+{
+    const Sphere &s0 = (*m_spheres)[sphereIndex1];
+    const Sphere &s1 = (*m_spheres)[sphereIndex2];
+
+    glm::vec3 v0 = s0.center;
+    glm::vec3 v1 = s1.center;
+    float r0 = s0.radius;
+    float r1 = s1.radius;
+
+    if (r1 < r0) {
+        std::swap(v0, v1);
+        std::swap(r0, r1);
+    }
+
+    glm::vec3 d = v0 - v1;
+    float dLength = glm::length(d);
+
+    float l = std::sqrt(glm::dot(d, d) - (r1 - r0) * (r1 - r0));
+
+    float r0Bis = r0 * (l / dLength);
+    float r1Bis = r1 * (l / dLength);
+
+    float d0 = (r1 - r0) * (r0 / dLength);
+    float d1 = (r1 - r0) * (r1 / dLength);
+
+    glm::vec3 v0Bis = v0 + glm::normalize(d) * d0;
+    glm::vec3 v1Bis = v1 + glm::normalize(d) * d1;
+
+    glm::vec3 arbitrary = (std::abs(d.x) < 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f)
+                                                  : glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec3 right = glm::normalize(glm::cross(d, arbitrary));
+    glm::vec3 up    = glm::normalize(glm::cross(right, d));
+
+    std::array<glm::vec3, SEGMENTS> circle1, circle2;
+    std::array<glm::vec3, SEGMENTS> normal1, normal2;
+
+    for (int i = 0; i < SEGMENTS; ++i) {
+        float theta = 2.0f * glm::pi<float>() * i / SEGMENTS;
+        glm::vec3 offset1 = (right * std::cos(theta) + up * std::sin(theta)) * r0Bis;
+        circle1[i] = v0Bis + offset1;
+        normal1[i] = glm::normalize(offset1);
+
+        glm::vec3 offset2 = (right * std::cos(theta) + up * std::sin(theta)) * r1Bis;
+        circle2[i] = v1Bis + offset2;
+        normal2[i] = glm::normalize(offset2);
+    }
+
+    for (int i = 0; i < SEGMENTS; ++i) {
+        int next = (i + 1) % SEGMENTS;
+
+        glm::vec3 p1 = circle1[i];
+        glm::vec3 p2 = circle2[i];
+        glm::vec3 p3 = circle1[next];
+        glm::vec3 p4 = circle2[next];
+
+        glm::vec3 n1 = normal1[i];
+        glm::vec3 n2 = normal2[i];
+        glm::vec3 n3 = normal1[next];
+        glm::vec3 n4 = normal2[next];
+
+        appendTriangle(p1, p2, p3, n1, n2, n3);
+        appendTriangle(p2, p4, p3, n2, n4, n3);
+    }
+}
+
+void BumperGeometryBuilder::buildGeometry(const BumperCapsuloid &caps)
+{
+    buildCapsuleBetweenSpheres(caps.sphereIndex[0], caps.sphereIndex[1]);
+}
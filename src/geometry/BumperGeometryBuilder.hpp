@@ -0,0 +1,77 @@
+#pragma once
+
+#include "bumper_graph.h"
+#include "BumperBuckets.hpp"
+#include "BumperGeometry.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Tessellates the bumpers of a graph into triangles.
+ *
+ * The builder takes the bumper topology already bucketed by type, so a graph
+ * loaded once is bucketed once however many builders it feeds; sphere positions
+ * are passed in explicitly so that a snapshot taken on another thread can be
+ * tessellated while the graph itself is being posed. No GL calls are made.
+ */
+class BumperGeometryBuilder
+{
+public:
+	explicit BumperGeometryBuilder(BumperBuckets buckets);
+
+	void build(const std::vector<SM::Sphere> &spheres, BumperGeometry &out);
+
+	// Re-tessellates, in place, only the bumpers touching one of dirtySpheres.
+	// geometry must come from build() on this builder with the same settings.
+	void rebuild(const std::vector<SM::Sphere> &spheres, const std::vector<uint32_t> &dirtySpheres,
+				 BumperGeometry &geometry);
+
+	const BumperBuckets &buckets() const;
+
+	// Buckets are split into submeshes of at most this many vertices, 0 for no limit
+	void setMaxSubMeshVertices(size_t count);
+	size_t maxSubMeshVertices() const;
+
+	static glm::vec3 computeUpperPlaneNormal(
+		const SM::Sphere &sa,
+		const SM::Sphere &sb,
+		const SM::Sphere &sc,
+		int direction);
+
+private:
+	BumperBuckets m_buckets;
+
+	size_t m_maxSubMeshVertices = BumperGeometry::MAX_SHORT_VERTICES;
+
+	const std::vector<SM::Sphere>* m_spheres = nullptr;
+	BumperGeometry* m_out = nullptr;
+	BumperGeometry::SubMesh m_sub {};
+
+	// While patching, triangles overwrite vertices from m_cursor on
+	bool m_patching = false;
+	size_t m_cursor = 0;
+
+	// Bumpers touching each sphere (CSR), as ordinals in bucket order
+	std::vector<uint32_t> m_sphereBumperOffsets;
+	std::vector<uint32_t> m_sphereBumpers;
+	std::vector<uint8_t> m_bumperMarks;
+	std::vector<uint32_t> m_dirtyBumpers;
+
+	void buildAdjacency(size_t sphereCount);
+	size_t firstVertexOf(uint32_t ordinal) const;
+	void rebuildBumper(uint32_t ordinal);
+
+	template <typename T>
+	void buildBucket(const std::vector<T> &bucket, const glm::vec3 &color);
+	void beginSubMesh(const glm::vec3 &color, size_t vertexCount);
+	void endSubMesh();
+
+	void buildGeometry(const SM::Graph::BumperPrysmoid &bp);
+	void buildGeometry(const SM::Graph::BumperQuad &bq);
+	void buildGeometry(const SM::Graph::BumperCapsuloid &caps);
+	void buildCapsuleBetweenSpheres(int sphereIndex1, int sphereIndex2);
+
+	void appendTriangle(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3,
+						const glm::vec3& n1, const glm::vec3& n2, const glm::vec3& n3);
+};
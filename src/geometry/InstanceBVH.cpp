@@ -0,0 +1,80 @@
+#include "InstanceBVH.hpp"
+
+#include <limits>
+
+void InstanceBVH::build(const std::vector<Instance> &instances)
+{
+    const size_t count = instances.size();
+
+    m_inverse.resize(count);
+    m_blas.resize(count);
+    m_triangles.resize(count);
+
+    std::vector<glm::vec3> mins(count), maxs(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Instance &instance = instances[i];
+        m_inverse[i] = glm::inverse(instance.transform);
+        m_blas[i] = instance.blas;
+        m_triangles[i] = instance.triangles;
+
+        glm::vec3 localMin, localMax;
+        if (instance.blas)
+            instance.blas->bounds(localMin, localMax);
+        else
+            instance.triangles->bounds(localMin, localMax);
+
+        // World box of the eight transformed corners
+        mins[i] = glm::vec3(std::numeric_limits<float>::max());
+        maxs[i] = glm::vec3(-std::numeric_limits<float>::max());
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 local((corner & 1) ? localMax.x : localMin.x,
+                                  (corner & 2) ? localMax.y : localMin.y,
+                                  (corner & 4) ? localMax.z : localMin.z);
+            const glm::vec3 world(instance.transform * glm::vec4(local, 1.0f));
+            mins[i] = glm::min(mins[i], world);
+            maxs[i] = glm::max(maxs[i], world);
+        }
+    }
+
+    m_bvh.build(mins, maxs, LEAF_SIZE);
+}
+
+size_t InstanceBVH::size() const
+{
+    return m_blas.size();
+}
+
+size_t InstanceBVH::bytes() const
+{
+    return m_bvh.bytes() + m_inverse.capacity() * sizeof(glm::mat4) +
+           m_blas.capacity() * sizeof(const SphereBVH*) + m_triangles.capacity() * sizeof(const TriangleBVH*);
+}
+
+bool InstanceBVH::intersect(const Ray &ray, RayHit &hit) const
+{
+    bool found = false;
+
+    float tMax = hit.t;
+    m_bvh.traverse(ray, tMax, [&](const uint32_t k, float &tLimit) {
+        const uint32_t i = m_bvh.order[k];
+
+        // The direction is not renormalized, so t stays comparable across instances
+        const Ray local {
+            glm::vec3(m_inverse[i] * glm::vec4(ray.origin, 1.0f)),
+            glm::vec3(m_inverse[i] * glm::vec4(ray.direction, 0.0f))
+        };
+
+        const bool intersected = m_blas[i] ? m_blas[i]->intersect(local, hit)
+                                           : m_triangles[i]->intersect(local, hit);
+        if (intersected)
+        {
+            tLimit = hit.t;
+            hit.instance = i;
+            found = true;
+        }
+    });
+
+    return found;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "BVH.hpp"
+#include "SphereBVH.hpp"
+#include "TriangleBVH.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Top level acceleration structure over transformed SphereBVH and
+ *        TriangleBVH instances.
+ *
+ * An instance references exactly one of the two. Each instance is bounded
+ * by the world space box of its transformed BLAS root. Rays are moved into
+ * instance space rather than rebuilding the BLAS, so many instances can share
+ * the spheres of one pose. The BLAS pointers are not owned and must outlive
+ * the next build().
+ */
+class InstanceBVH
+{
+public:
+	struct Instance
+	{
+		glm::mat4 transform { 1.0f };
+		const SphereBVH* blas = nullptr;
+		const TriangleBVH* triangles = nullptr;
+	};
+
+	static constexpr uint32_t LEAF_SIZE = 2;
+
+	void build(const std::vector<Instance> &instances);
+
+	size_t size() const;
+	size_t bytes() const;
+
+	bool intersect(const Ray &ray, RayHit &hit) const;
+
+private:
+	BVH m_bvh;
+
+	// Indexed like the instances passed to build()
+	std::vector<glm::mat4> m_inverse;
+	std::vector<const SphereBVH*> m_blas;
+	std::vector<const TriangleBVH*> m_triangles;
+};
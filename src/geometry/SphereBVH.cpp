@@ -0,0 +1,101 @@
+#include "SphereBVH.hpp"
+
+#include <cmath>
+#include <utility>
+
+void SphereBVH::build(const SphereSoA &spheres)
+{
+    const size_t count = spheres.size();
+
+    std::vector<glm::vec3> mins(count), maxs(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const glm::vec3 center(spheres.x[i], spheres.y[i], spheres.z[i]);
+        const glm::vec3 extent(std::fabs(spheres.r[i]));
+        mins[i] = center - extent;
+        maxs[i] = center + extent;
+    }
+
+    m_bvh.build(mins, maxs, LEAF_SIZE);
+
+    m_spheres.resize(count);
+    for (size_t k = 0; k < count; k++)
+    {
+        const uint32_t i = m_bvh.order[k];
+        m_spheres[k] = glm::vec4(spheres.x[i], spheres.y[i], spheres.z[i], spheres.r[i]);
+    }
+}
+
+void SphereBVH::assign(BVH bvh, std::vector<glm::vec4> leafSpheres)
+{
+    m_bvh = std::move(bvh);
+    m_spheres = std::move(leafSpheres);
+}
+
+const BVH &SphereBVH::hierarchy() const
+{
+    return m_bvh;
+}
+
+const std::vector<glm::vec4> &SphereBVH::leafSpheres() const
+{
+    return m_spheres;
+}
+
+bool SphereBVH::empty() const
+{
+    return m_bvh.empty();
+}
+
+void SphereBVH::bounds(glm::vec3 &min, glm::vec3 &max) const
+{
+    if (m_bvh.empty())
+    {
+        min = max = glm::vec3(0.0f);
+        return;
+    }
+
+    min = m_bvh.nodes[0].min;
+    max = m_bvh.nodes[0].max;
+}
+
+size_t SphereBVH::bytes() const
+{
+    return m_bvh.bytes() + m_spheres.capacity() * sizeof(glm::vec4);
+}
+
+bool SphereBVH::intersect(const Ray &ray, RayHit &hit) const
+{
+    const float a = glm::dot(ray.direction, ray.direction);
+    bool found = false;
+
+    float tMax = hit.t;
+    m_bvh.traverse(ray, tMax, [&](const uint32_t k, float &tLimit) {
+        const glm::vec3 center(m_spheres[k]);
+        const float radius = m_spheres[k].w;
+
+        const glm::vec3 oc = ray.origin - center;
+        const float b = glm::dot(oc, ray.direction);
+        const float c = glm::dot(oc, oc) - radius * radius;
+        const float discriminant = b * b - a * c;
+        if (discriminant < 0.0f)
+            return;
+
+        // Rays starting inside a sphere hit its far side
+        const float root = std::sqrt(discriminant);
+        float t = (-b - root) / a;
+        if (t <= 0.0f)
+            t = (-b + root) / a;
+
+        if (t > 0.0f && t < tLimit)
+        {
+            tLimit = t;
+            hit.t = t;
+            hit.sphere = m_bvh.order[k];
+            hit.triangle = RayHit::NONE;
+            found = true;
+        }
+    });
+
+    return found;
+}
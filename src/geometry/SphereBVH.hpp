@@ -0,0 +1,38 @@
+#pragma once
+
+#include "BVH.hpp"
+#include "SphereSoA.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Bottom level acceleration structure over the spheres of one pose.
+ *
+ * Spheres are copied in leaf order, so a leaf tests a contiguous run of
+ * memory. Hits report the sphere's index in the source SoA.
+ */
+class SphereBVH
+{
+public:
+	static constexpr uint32_t LEAF_SIZE = 4;
+
+	void build(const SphereSoA &spheres);
+
+	bool empty() const;
+	void bounds(glm::vec3 &min, glm::vec3 &max) const;
+	size_t bytes() const;
+
+	bool intersect(const Ray &ray, RayHit &hit) const;
+
+	// Restores a hierarchy saved from hierarchy() and leafSpheres(), e.g. by AssetCache
+	void assign(BVH bvh, std::vector<glm::vec4> leafSpheres);
+	const BVH &hierarchy() const;
+	const std::vector<glm::vec4> &leafSpheres() const;
+
+private:
+	BVH m_bvh;
+
+	// center xyz, radius w, in leaf order
+	std::vector<glm::vec4> m_spheres;
+};
@@ -0,0 +1,36 @@
+#include "SphereDelta.hpp"
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+void SphereDelta::clear()
+{
+    indices.clear();
+}
+
+bool SphereDelta::empty() const
+{
+    return indices.empty();
+}
+
+size_t SphereDelta::size() const
+{
+    return indices.size();
+}
+
+void SphereDelta::diff(const std::vector<SM::Sphere> &before, const std::vector<SM::Sphere> &after,
+                       SphereDelta &out, const float epsilon)
+{
+    out.clear();
+
+    for (size_t i = 0; i < after.size(); i++)
+    {
+        const glm::vec4 d = i < before.size()
+            ? glm::vec4(after[i].center - before[i].center, after[i].radius - before[i].radius)
+            : glm::vec4(after[i].center, after[i].radius);
+
+        if (std::fabs(d.x) > epsilon || std::fabs(d.y) > epsilon ||
+            std::fabs(d.z) > epsilon || std::fabs(d.w) > epsilon)
+            out.indices.push_back(static_cast<uint32_t>(i));
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "sphere_mesh.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Sparse list of the spheres a pose change displaced.
+ *
+ * Holds the indices of the spheres whose center or radius moved, found by
+ * comparing two pose snapshots. The list is the dirty set handed to
+ * downstream stages, so they only touch what actually moved.
+ */
+struct SphereDelta
+{
+	std::vector<uint32_t> indices;
+
+	void clear();
+	bool empty() const;
+	size_t size() const;
+
+	static void diff(const std::vector<SM::Sphere> &before, const std::vector<SM::Sphere> &after,
+					 SphereDelta &out, float epsilon = 0.0f);
+};
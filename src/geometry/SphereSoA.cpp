@@ -0,0 +1,99 @@
+#include "SphereSoA.hpp"
+
+#include <algorithm>
+#include <limits>
+
+void SphereSoA::resize(const size_t count)
+{
+    const size_t padded = (count + LANES - 1) / LANES * LANES;
+
+    m_count = count;
+    x.assign(padded, 0.0f);
+    y.assign(padded, 0.0f);
+    z.assign(padded, 0.0f);
+    r.assign(padded, 0.0f);
+}
+
+void SphereSoA::assign(const std::vector<SM::Sphere> &spheres)
+{
+    if (spheres.size() != m_count)
+        resize(spheres.size());
+
+    for (size_t i = 0; i < m_count; i++)
+    {
+        x[i] = spheres[i].center.x;
+        y[i] = spheres[i].center.y;
+        z[i] = spheres[i].center.z;
+        r[i] = spheres[i].radius;
+    }
+}
+
+void SphereSoA::set(const size_t index, const SM::Sphere &sphere)
+{
+    x[index] = sphere.center.x;
+    y[index] = sphere.center.y;
+    z[index] = sphere.center.z;
+    r[index] = sphere.radius;
+}
+
+size_t SphereSoA::size() const
+{
+    return m_count;
+}
+
+size_t SphereSoA::paddedSize() const
+{
+    return x.size();
+}
+
+size_t SphereSoA::bytes() const
+{
+    return 4 * x.capacity() * sizeof(float);
+}
+
+SM::Sphere SphereSoA::sphere(const size_t index) const
+{
+    SM::Sphere s;
+    s.center = glm::vec3(x[index], y[index], z[index]);
+    s.radius = r[index];
+    return s;
+}
+
+glm::vec3 SphereSoA::centroid() const
+{
+    if (m_count == 0)
+        return glm::vec3(0.0f);
+
+    // One accumulator per lane keeps the loop vectorizable without reassociation
+    float sx[LANES] = {}, sy[LANES] = {}, sz[LANES] = {};
+    for (size_t i = 0; i < paddedSize(); i += LANES)
+        for (size_t l = 0; l < LANES; l++)
+        {
+            sx[l] += x[i + l];
+            sy[l] += y[i + l];
+            sz[l] += z[i + l];
+        }
+
+    glm::vec3 sum(0.0f);
+    for (size_t l = 0; l < LANES; l++)
+        sum += glm::vec3(sx[l], sy[l], sz[l]);
+
+    return sum / static_cast<float>(m_count);
+}
+
+void SphereSoA::bounds(glm::vec3 &min, glm::vec3 &max) const
+{
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    min = glm::vec3(inf);
+    max = glm::vec3(-inf);
+
+    for (size_t i = 0; i < m_count; i++)
+    {
+        min.x = std::min(min.x, x[i] - r[i]);
+        min.y = std::min(min.y, y[i] - r[i]);
+        min.z = std::min(min.z, z[i] - r[i]);
+        max.x = std::max(max.x, x[i] + r[i]);
+        max.y = std::max(max.y, y[i] + r[i]);
+        max.z = std::max(max.z, z[i] + r[i]);
+    }
+}
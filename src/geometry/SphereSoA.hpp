@@ -0,0 +1,44 @@
+#pragma once
+
+#include "sphere_mesh.h"
+#include "../core/AlignedAllocator.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Structure-of-arrays mirror of a sphere array.
+ *
+ * Each component lives in its own 64-byte aligned array whose length is
+ * padded to a multiple of LANES, so batch kernels can run full-width vector
+ * loops without a scalar tail. Padding entries are zero; kernels that are not
+ * neutral to zero spheres must stop at size().
+ */
+struct SphereSoA
+{
+	static constexpr size_t ALIGNMENT = 64;
+	static constexpr size_t LANES = ALIGNMENT / sizeof(float);
+
+	using Array = std::vector<float, AlignedAllocator<float, ALIGNMENT>>;
+
+	Array x;
+	Array y;
+	Array z;
+	Array r;
+
+	void resize(size_t count);
+	void assign(const std::vector<SM::Sphere> &spheres);
+	void set(size_t index, const SM::Sphere &sphere);
+
+	size_t size() const;
+	size_t paddedSize() const;
+	size_t bytes() const;
+
+	SM::Sphere sphere(size_t index) const;
+
+	glm::vec3 centroid() const;
+	void bounds(glm::vec3 &min, glm::vec3 &max) const;
+
+private:
+	size_t m_count = 0;
+};
@@ -0,0 +1,140 @@
+#include "SyntheticGraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+using namespace SM;
+using namespace SM::Graph;
+
+namespace
+{
+    // SplitMix64: integer only, so the sequence is identical on every compiler and standard library
+    class Random
+    {
+    public:
+        explicit Random(const uint64_t seed)
+            : m_state(seed)
+        {
+        }
+
+        uint64_t next()
+        {
+            uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [0, 1), from the top 24 bits so every value is exact in a float
+        float uniform()
+        {
+            return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+        }
+
+        float uniform(const float min, const float max)
+        {
+            return min + (max - min) * uniform();
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    template <typename T>
+    Bumper makeBumper(const decltype(Bumper::shapeType) type, const std::initializer_list<size_t> corners)
+    {
+        T shape {};
+        size_t c = 0;
+        for (const size_t index : corners)
+            shape.sphereIndex[c++] = static_cast<int>(index);
+
+        Bumper b {};
+        b.shapeType = type;
+        b.bumper = shape;
+        return b;
+    }
+}
+
+bool SyntheticGraph::Mix::isValid() const
+{
+    for (const float weight : { quads, prysmoids, capsuloids })
+        if (!std::isfinite(weight) || weight < 0.0f)
+            return false;
+    return true;
+}
+
+bool SyntheticGraph::generate(const Parameters &parameters, BumperGraph &graph)
+{
+    graph.sphere.clear();
+    graph.bumper.clear();
+
+    if (!parameters.mix.isValid())
+        return false;
+
+    const size_t count = parameters.sphereCount;
+    if (count == 0)
+        return true;
+
+    const size_t columns = std::max<size_t>(1, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count)))));
+    const size_t rows = (count + columns - 1) / columns;
+    const float spacing = 1.0f / static_cast<float>(columns);
+
+    // Spheres and cells draw from separate sequences, so changing the mix keeps the spheres
+    Random sphereRandom(parameters.seed);
+    Random cellRandom(parameters.seed ^ 0xD1B54A32D192ED03ull);
+
+    graph.sphere.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float u = static_cast<float>(i % columns) / static_cast<float>(columns) - 0.5f;
+        const float v = static_cast<float>(i / columns) / static_cast<float>(columns) - 0.5f;
+
+        // A dome over the unit square, zero at its edges; u and v stay within [-0.5, 0.5)
+        const float dome = (1.0f - 4.0f * u * u) * (1.0f - 4.0f * v * v);
+
+        Sphere &s = graph.sphere[i];
+        s.center = glm::vec3(u + sphereRandom.uniform(-0.15f, 0.15f) * spacing,
+                             v + sphereRandom.uniform(-0.15f, 0.15f) * spacing,
+                             0.05f * dome);
+        s.radius = sphereRandom.uniform(0.2f, 0.4f) * spacing;
+    }
+
+    const Mix &mix = parameters.mix;
+    const float total = mix.quads + mix.prysmoids + mix.capsuloids;
+    const float quadShare = total > 0.0f ? mix.quads / total : 0.0f;
+    const float prysmoidShare = total > 0.0f ? mix.prysmoids / total : 1.0f;
+
+    // Only cells whose four corners exist; the last row may be partial
+    graph.bumper.reserve(2 * columns * rows);
+    for (size_t row = 0; row + 1 < rows; row++)
+    {
+        for (size_t column = 0; column + 1 < columns; column++)
+        {
+            const size_t a = row * columns + column;
+            const size_t b = a + 1;
+            const size_t c = a + columns + 1;
+            const size_t d = a + columns;
+            if (c >= count)
+                continue;
+
+            const float pick = cellRandom.uniform();
+            if (pick < quadShare)
+            {
+                graph.bumper.push_back(makeBumper<BumperQuad>(Bumper::QUAD, { a, b, c, d }));
+            }
+            else if (pick < quadShare + prysmoidShare)
+            {
+                graph.bumper.push_back(makeBumper<BumperPrysmoid>(Bumper::PRYSMOID, { a, b, c }));
+                graph.bumper.push_back(makeBumper<BumperPrysmoid>(Bumper::PRYSMOID, { a, c, d }));
+            }
+            else
+            {
+                graph.bumper.push_back(makeBumper<BumperCapsuloid>(Bumper::CAPSULOID, { a, b }));
+                graph.bumper.push_back(makeBumper<BumperCapsuloid>(Bumper::CAPSULOID, { a, d }));
+            }
+        }
+    }
+
+    return true;
+}
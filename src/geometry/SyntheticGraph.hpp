@@ -0,0 +1,44 @@
+#pragma once
+
+#include "bumper_graph.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Generates bumper graphs of any size for scaling tests.
+ *
+ * Spheres are laid out on a jittered, gently curved grid filling the unit
+ * square, and every grid cell becomes a quad, two prysmoids or two capsuloids,
+ * picked with the weights of the mix. No platform library takes part: the
+ * random numbers come from a fixed SplitMix64 sequence rather than the
+ * <random> distributions, and the curvature is a polynomial rather than
+ * std::sin. The output then depends only on the parameters and on IEEE float
+ * arithmetic; builds that fuse multiply-adds may differ in the last bit.
+ *
+ * The graph is built directly, without a SphereMesh, so it carries no blend
+ * shapes and posing it leaves the rest pose.
+ */
+class SyntheticGraph
+{
+public:
+	struct Mix
+	{
+		float quads = 0.2f;
+		float prysmoids = 0.6f;
+		float capsuloids = 0.2f;
+
+		// Weights must be finite and non-negative; all zero means prysmoids only
+		bool isValid() const;
+	};
+
+	struct Parameters
+	{
+		size_t sphereCount = 1000;
+		Mix mix;
+		uint64_t seed = 1;
+	};
+
+	// Leaves the graph empty and returns false for an invalid mix
+	static bool generate(const Parameters &parameters, SM::Graph::BumperGraph &graph);
+};
@@ -0,0 +1,108 @@
+#include "TriangleBVH.hpp"
+
+#include <cmath>
+
+void TriangleBVH::build(const BumperGeometry &geometry)
+{
+    std::vector<Triangle> triangles;
+    triangles.reserve(geometry.indexCount() / 3);
+
+    for (const auto &sub : geometry.subMeshes)
+    {
+        const auto index = [&](const size_t i) -> size_t {
+            return sub.baseVertex + (sub.wideIndices ? geometry.indices32[sub.indexOffset + i]
+                                                     : geometry.indices16[sub.indexOffset + i]);
+        };
+
+        for (size_t i = 0; i + 2 < sub.indexCount; i += 3)
+        {
+            const glm::vec3 &a = geometry.vertices[index(i)].position;
+            const glm::vec3 &b = geometry.vertices[index(i + 1)].position;
+            const glm::vec3 &c = geometry.vertices[index(i + 2)].position;
+            triangles.push_back({ a, b - a, c - a });
+        }
+    }
+
+    const size_t count = triangles.size();
+    std::vector<glm::vec3> mins(count), maxs(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Triangle &t = triangles[i];
+        const glm::vec3 b = t.v0 + t.e1;
+        const glm::vec3 c = t.v0 + t.e2;
+        mins[i] = glm::min(t.v0, glm::min(b, c));
+        maxs[i] = glm::max(t.v0, glm::max(b, c));
+    }
+
+    m_bvh.build(mins, maxs, LEAF_SIZE);
+
+    m_triangles.resize(count);
+    for (size_t k = 0; k < count; k++)
+        m_triangles[k] = triangles[m_bvh.order[k]];
+}
+
+bool TriangleBVH::empty() const
+{
+    return m_bvh.empty();
+}
+
+size_t TriangleBVH::size() const
+{
+    return m_triangles.size();
+}
+
+void TriangleBVH::bounds(glm::vec3 &min, glm::vec3 &max) const
+{
+    if (m_bvh.empty())
+    {
+        min = max = glm::vec3(0.0f);
+        return;
+    }
+
+    min = m_bvh.nodes[0].min;
+    max = m_bvh.nodes[0].max;
+}
+
+size_t TriangleBVH::bytes() const
+{
+    return m_bvh.bytes() + m_triangles.capacity() * sizeof(Triangle);
+}
+
+bool TriangleBVH::intersect(const Ray &ray, RayHit &hit) const
+{
+    constexpr float EPSILON = 1e-7f;
+    bool found = false;
+
+    float tMax = hit.t;
+    m_bvh.traverse(ray, tMax, [&](const uint32_t k, float &tLimit) {
+        const Triangle &tri = m_triangles[k];
+
+        const glm::vec3 p = glm::cross(ray.direction, tri.e2);
+        const float det = glm::dot(tri.e1, p);
+        if (std::fabs(det) < EPSILON)
+            return;
+
+        const float invDet = 1.0f / det;
+        const glm::vec3 s = ray.origin - tri.v0;
+        const float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+            return;
+
+        const glm::vec3 q = glm::cross(s, tri.e1);
+        const float v = glm::dot(ray.direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+            return;
+
+        const float t = glm::dot(tri.e2, q) * invDet;
+        if (t > 0.0f && t < tLimit)
+        {
+            tLimit = t;
+            hit.t = t;
+            hit.triangle = m_bvh.order[k];
+            hit.sphere = RayHit::NONE;
+            found = true;
+        }
+    });
+
+    return found;
+}
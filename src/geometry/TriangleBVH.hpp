@@ -0,0 +1,43 @@
+#pragma once
+
+#include "BVH.hpp"
+#include "BumperGeometry.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Bottom level acceleration structure over the triangles of a mesh.
+ *
+ * Takes the submesh layout of BumperGeometry, so imported props and
+ * tessellated bumpers share one format. Triangles are numbered in submesh
+ * order and copied in leaf order as a vertex and two edges, ready for the
+ * Moller-Trumbore test. Both faces are hit.
+ */
+class TriangleBVH
+{
+public:
+	static constexpr uint32_t LEAF_SIZE = 4;
+
+	void build(const BumperGeometry &geometry);
+
+	bool empty() const;
+	size_t size() const;
+	void bounds(glm::vec3 &min, glm::vec3 &max) const;
+	size_t bytes() const;
+
+	bool intersect(const Ray &ray, RayHit &hit) const;
+
+private:
+	struct Triangle
+	{
+		glm::vec3 v0;
+		glm::vec3 e1;
+		glm::vec3 e2;
+	};
+
+	BVH m_bvh;
+
+	// In leaf order
+	std::vector<Triangle> m_triangles;
+};
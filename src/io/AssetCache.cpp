@@ -0,0 +1,256 @@
+#include "AssetCache.hpp"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+using namespace SM;
+using namespace SM::Graph;
+
+namespace
+{
+    constexpr char MAGIC[4] = { 'S', 'M', 'C', 'A' };
+    constexpr uint32_t VERSION = 2;
+    constexpr uint64_t ALIGNMENT = SphereSoA::ALIGNMENT;
+
+    uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    struct Part
+    {
+        const void* data;
+        uint64_t bytes;
+    };
+
+    struct Pending
+    {
+        uint32_t elementSize;
+        uint64_t count;
+        std::vector<Part> parts;
+    };
+
+    template <typename T, typename A>
+    Pending pendingOf(const std::vector<T, A> &values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "cache sections are written as raw bytes");
+        return { sizeof(T), values.size(), { { values.data(), values.size() * sizeof(T) } } };
+    }
+
+    template <typename T, typename A>
+    void copySection(const uchar* data, const uint64_t offset, const uint64_t count, std::vector<T, A> &values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "cache sections are read as raw bytes");
+        values.resize(count);
+        if (count > 0)
+            std::memcpy(values.data(), data + offset, count * sizeof(T));
+    }
+
+    bool writePadding(QSaveFile &file, const uint64_t target)
+    {
+        static const char zeros[ALIGNMENT] = {};
+        const qint64 missing = static_cast<qint64>(target) - file.pos();
+        return missing <= 0 || file.write(zeros, missing) == missing;
+    }
+}
+
+QByteArray AssetCache::keyFor(const QString &sourcePath)
+{
+    QFile file(sourcePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file))
+        return {};
+    return hash.result();
+}
+
+QString AssetCache::directory()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("meshes");
+}
+
+QString AssetCache::pathFor(const QByteArray &key)
+{
+    return QDir(directory()).filePath(QString::fromLatin1(key.toHex()) + ".smc");
+}
+
+bool AssetCache::load(const QByteArray &key, const BumperGraph &graph, SphereBVH &bvh)
+{
+    const QString path = pathFor(key);
+    if (key.size() != sizeof(Header::key) || !QFileInfo::exists(path))
+        return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = file.size();
+    if (fileSize < static_cast<qint64>(sizeof(Header) + SECTION_COUNT * sizeof(Section)))
+    {
+        qDebug() << "Dropping truncated asset cache entry:" << path;
+        file.remove();
+        return false;
+    }
+
+    const uchar* data = file.map(0, fileSize);
+    if (!data)
+    {
+        qDebug() << "Cannot map asset cache entry:" << path << file.errorString();
+        return false;
+    }
+
+    Header header {};
+    Section sections[SECTION_COUNT] {};
+    std::memcpy(&header, data, sizeof(Header));
+    std::memcpy(sections, data + sizeof(Header), sizeof(sections));
+
+    // Element sizes catch entries written by a build with a different struct layout
+    constexpr uint32_t elementSizes[SECTION_COUNT] = { sizeof(float), sizeof(BVH::Node), sizeof(uint32_t) };
+
+    bool valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION &&
+                 std::memcmp(header.key, key.constData(), sizeof(header.key)) == 0 &&
+                 header.sectionCount == SECTION_COUNT && header.fileSize <= static_cast<uint64_t>(fileSize) &&
+                 header.paddedCount >= header.sphereCount;
+
+    // Bounded with a division, so crafted counts cannot wrap the end of a section
+    for (uint32_t i = 0; valid && i < SECTION_COUNT; i++)
+    {
+        const Section &section = sections[i];
+        valid = section.id == i && section.elementSize == elementSizes[i] && section.offset % ALIGNMENT == 0 &&
+                section.offset <= header.fileSize &&
+                section.count <= (header.fileSize - section.offset) / section.elementSize;
+    }
+
+    valid = valid && sections[SPHERES].count == 4ull * header.paddedCount;
+
+    if (!valid)
+    {
+        qDebug() << "Dropping invalid asset cache entry:" << path;
+        file.unmap(const_cast<uchar*>(data));
+        file.remove();
+        return false;
+    }
+
+    // The BVH only describes these spheres if they are exactly the ones constructed this run
+    const size_t count = header.sphereCount;
+    const size_t padded = header.paddedCount;
+    const auto* block = reinterpret_cast<const float*>(data + sections[SPHERES].offset);
+
+    bool matches = count == graph.sphere.size();
+    for (size_t i = 0; matches && i < count; i++)
+    {
+        const Sphere &s = graph.sphere[i];
+        const float stored[4] = { block[i], block[padded + i], block[2 * padded + i], block[3 * padded + i] };
+        const float constructed[4] = { s.center.x, s.center.y, s.center.z, s.radius };
+        matches = std::memcmp(stored, constructed, sizeof(stored)) == 0;
+    }
+
+    BVH hierarchy;
+    if (matches)
+    {
+        copySection(data, sections[BVH_NODES].offset, sections[BVH_NODES].count, hierarchy.nodes);
+        copySection(data, sections[BVH_ORDER].offset, sections[BVH_ORDER].count, hierarchy.order);
+    }
+    file.unmap(const_cast<uchar*>(data));
+
+    if (!matches || !hierarchy.isValid(count))
+    {
+        qDebug() << "Dropping stale asset cache entry:" << path;
+        file.remove();
+        return false;
+    }
+
+    // Leaf spheres follow from the order, no need to store them twice
+    std::vector<glm::vec4> leafSpheres(hierarchy.order.size());
+    for (size_t k = 0; k < leafSpheres.size(); k++)
+    {
+        const Sphere &s = graph.sphere[hierarchy.order[k]];
+        leafSpheres[k] = glm::vec4(s.center, s.radius);
+    }
+    bvh.assign(std::move(hierarchy), std::move(leafSpheres));
+
+    return true;
+}
+
+bool AssetCache::store(const QByteArray &key, const BumperGraph &graph, const SphereBVH &bvh)
+{
+    if (key.size() != sizeof(Header::key))
+        return false;
+
+    if (!QDir().mkpath(directory()))
+    {
+        qDebug() << "Cannot create asset cache directory:" << directory();
+        return false;
+    }
+
+    SphereSoA soa;
+    soa.assign(graph.sphere);
+
+    const uint64_t componentBytes = soa.paddedSize() * sizeof(float);
+    const Pending pending[SECTION_COUNT] = {
+        { sizeof(float), 4 * soa.paddedSize(),
+          { { soa.x.data(), componentBytes }, { soa.y.data(), componentBytes },
+            { soa.z.data(), componentBytes }, { soa.r.data(), componentBytes } } },
+        pendingOf(bvh.hierarchy().nodes),
+        pendingOf(bvh.hierarchy().order)
+    };
+    // Sections follow the table, each starting on an aligned offset
+    Section sections[SECTION_COUNT] {};
+    uint64_t offset = alignUp(sizeof(Header) + sizeof(sections), ALIGNMENT);
+    for (uint32_t i = 0; i < SECTION_COUNT; i++)
+    {
+        sections[i] = { i, pending[i].elementSize, offset, pending[i].count };
+        offset = alignUp(offset + pending[i].count * pending[i].elementSize, ALIGNMENT);
+    }
+
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    std::memcpy(header.key, key.constData(), sizeof(header.key));
+    header.sphereCount = static_cast<uint32_t>(soa.size());
+    header.paddedCount = static_cast<uint32_t>(soa.paddedSize());
+    header.sectionCount = SECTION_COUNT;
+    header.fileSize = sections[SECTION_COUNT - 1].offset +
+                      sections[SECTION_COUNT - 1].count * sections[SECTION_COUNT - 1].elementSize;
+
+    // QSaveFile only replaces the entry once it is complete
+    const QString path = pathFor(key);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Cannot write asset cache entry:" << path << file.errorString();
+        return false;
+    }
+
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header);
+    ok = ok && file.write(reinterpret_cast<const char*>(sections), sizeof(sections)) == sizeof(sections);
+
+    for (uint32_t i = 0; ok && i < SECTION_COUNT; i++)
+    {
+        ok = writePadding(file, sections[i].offset);
+        for (const Part &part : pending[i].parts)
+        {
+            const auto bytes = static_cast<qint64>(part.bytes);
+            ok = ok && file.write(static_cast<const char*>(part.data), bytes) == bytes;
+        }
+    }
+
+    if (!ok || !file.commit())
+    {
+        qDebug() << "Error while writing asset cache entry:" << path << file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <cstdint>
+
+#include "bumper_graph.h"
+#include "../geometry/SphereBVH.hpp"
+
+/**
+ * @brief On-disk cache of the rest pose sphere BVH of a sphere mesh.
+ *
+ * The graph itself is always built by BumperGraph::constructFrom: posing
+ * depends on the blend-shape state it sets up, which the library keeps
+ * private, so neither the graph nor its buckets can be restored from disk.
+ * What the cache saves is the BVH build over the constructed rest spheres.
+ * The crowd asks for it on its first build, off the GUI thread, so loading a
+ * mesh never pays for the hash or the BVH.
+ *
+ * Entries are keyed by the SHA-1 of the source file. A hit is only used when
+ * the rest spheres stored with the entry equal the constructed ones bit for
+ * bit, so an entry can never describe another state of the mesh. An
+ * entry is one file: a header, a section table and 64-byte aligned sections;
+ * every section and every BVH index is checked against the file and the
+ * graph on load.
+ *
+ * Entries live in QStandardPaths::CacheLocation and can be deleted at any time.
+ */
+class AssetCache
+{
+public:
+	static QByteArray keyFor(const QString &sourcePath);
+
+	static QString directory();
+	static QString pathFor(const QByteArray &key);
+
+	static bool load(const QByteArray &key, const SM::Graph::BumperGraph &graph, SphereBVH &bvh);
+	static bool store(const QByteArray &key, const SM::Graph::BumperGraph &graph, const SphereBVH &bvh);
+
+private:
+	enum SectionId : uint32_t {
+		SPHERES,
+		BVH_NODES,
+		BVH_ORDER,
+		SECTION_COUNT
+	};
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint8_t key[20];
+		uint32_t sphereCount;
+		uint32_t paddedCount;
+		uint32_t sectionCount;
+		uint64_t fileSize;
+		uint8_t reserved[16];
+	};
+	static_assert(sizeof(Header) == 64, "asset cache header must stay 64 bytes");
+
+	struct Section {
+		uint32_t id;
+		uint32_t elementSize;
+		uint64_t offset;
+		uint64_t count;
+	};
+	static_assert(sizeof(Section) == 24, "asset cache sections are written as two uint32 and two uint64");
+};
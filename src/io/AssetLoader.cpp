@@ -0,0 +1,84 @@
+#include "AssetLoader.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <utility>
+
+#include "SphereMeshFile.hpp"
+#include "../geometry/BumperGeometryBuilder.hpp"
+
+std::shared_ptr<AssetLoader::Asset> AssetLoader::load(const QString &path, const ProgressCallback &progress)
+{
+    auto report = [&progress](const QString &stage, const float value) {
+        if (progress)
+            progress(stage, value);
+    };
+
+    auto asset = std::make_shared<Asset>();
+    asset->path = path;
+    asset->graph = std::make_unique<SM::Graph::BumperGraph>();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    if (!QFileInfo::exists(path))
+    {
+        qDebug() << "Sphere mesh not found:" << path;
+        report("Sphere mesh not found", 1.0f);
+        return asset;
+    }
+
+    if (QFileInfo(path).suffix() == "smb")
+    {
+        report("Reading sphere mesh", 0.0f);
+
+        auto progressTo = [&report](const float value) {
+            report("Reading sphere mesh", 0.7f * value);
+        };
+
+        // Mapped and copied straight into the graph; streamed in chunks where the file cannot be mapped
+        SphereMeshFile file;
+        bool read = file.open(path);
+        if (read)
+            file.copyTo(*asset->graph, progressTo);
+        else
+            read = SphereMeshFile::read(path, *asset->graph, SphereMeshFile::DEFAULT_CHUNK_BYTES, progressTo);
+        if (!read)
+        {
+            report("Cannot read sphere mesh", 1.0f);
+            return asset;
+        }
+        asset->buckets = BumperBuckets::from(*asset->graph);
+    }
+    else
+    {
+        report("Reading sphere mesh", 0.0f);
+        asset->sphereMesh = std::make_unique<SM::SphereMesh>();
+        asset->sphereMesh->loadFromFile(path.toStdString());
+
+        // Always constructed: posing relies on state the library sets up here
+        report("Building bumper graph", 0.3f);
+        asset->graph->constructFrom(*asset->sphereMesh);
+        asset->buckets = BumperBuckets::from(*asset->graph);
+        asset->sphereMesh->inflate(-0.075f);
+    }
+
+    if (asset->graph->sphere.empty())
+    {
+        qDebug() << "Sphere mesh is empty:" << path;
+        report("Sphere mesh is empty", 1.0f);
+        return asset;
+    }
+
+    report("Tessellating bumpers", 0.7f);
+    BumperGeometryBuilder builder(asset->buckets);
+    builder.build(asset->graph->sphere, asset->geometry);
+
+    asset->ok = true;
+    qDebug() << "Loaded" << path << "in" << clock.elapsed() << "ms:" << asset->graph->sphere.size() << "spheres,"
+             << asset->graph->bumper.size() << "bumpers";
+    report("Ready", 1.0f);
+    return asset;
+}
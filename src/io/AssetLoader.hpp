@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+
+#include <functional>
+#include <memory>
+
+#include "bumper_graph.h"
+#include "sphere_mesh.h"
+#include "../geometry/BumperBuckets.hpp"
+#include "../geometry/BumperGeometry.hpp"
+
+/**
+ * @brief Loads a sphere mesh and prepares its first geometry without touching GL,
+ *        so it can run off the GUI thread.
+ *
+ * Text meshes (.sm) go through the library loader and keep their SphereMesh
+ * for posing. Binary meshes (.smb) are streamed into the graph in chunks
+ * with progress per chunk, but carry no blend shapes and stay at the rest pose.
+ * The library calls are opaque, so text meshes report progress per stage.
+ */
+class AssetLoader
+{
+public:
+	struct Asset {
+		QString path;
+		std::unique_ptr<SM::SphereMesh> sphereMesh;
+		std::unique_ptr<SM::Graph::BumperGraph> graph;
+		BumperBuckets buckets; // bucketed once here, copied into every builder of the graph
+		BumperGeometry geometry;
+		bool ok = false;
+
+		bool isPosable() const { return sphereMesh != nullptr; }
+	};
+
+	using ProgressCallback = std::function<void(const QString &stage, float progress)>;
+
+	static std::shared_ptr<Asset> load(const QString &path, const ProgressCallback &progress = {});
+};
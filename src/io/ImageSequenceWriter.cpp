@@ -0,0 +1,127 @@
+#include "ImageSequenceWriter.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QImageWriter>
+
+#include <algorithm>
+#include <utility>
+
+ImageSequenceWriter::ImageSequenceWriter(const QString &directory, const QString &baseName, const QByteArray &format,
+                                         const size_t queueCapacity, const size_t encoderThreads)
+    : m_directory(directory)
+    , m_baseName(baseName)
+    , m_format(format.toLower())
+    , m_capacity(std::max<size_t>(1, queueCapacity))
+    , m_encoders(std::max<size_t>(1, encoderThreads))
+{
+    if (!QImageWriter::supportedImageFormats().contains(m_format))
+    {
+        qDebug() << "No image plugin writes" << m_format << "- writing PNG instead";
+        m_format = "png";
+    }
+
+    if (!QDir().mkpath(m_directory))
+        qDebug() << "Cannot create frame directory:" << m_directory;
+}
+
+ImageSequenceWriter::~ImageSequenceWriter()
+{
+    finish();
+}
+
+bool ImageSequenceWriter::write(QImage frame)
+{
+    size_t index;
+    {
+        std::unique_lock lock(m_mutex);
+        m_slotFreed.wait(lock, [this] { return m_inFlight < m_capacity; });
+        m_inFlight++;
+        index = m_nextFrame++;
+    }
+
+    enqueue(std::move(frame), index);
+    return true;
+}
+
+bool ImageSequenceWriter::tryWrite(QImage frame)
+{
+    size_t index;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_inFlight >= m_capacity)
+        {
+            m_stats.dropped++;
+            return false;
+        }
+        m_inFlight++;
+        index = m_nextFrame++;
+    }
+
+    enqueue(std::move(frame), index);
+    return true;
+}
+
+void ImageSequenceWriter::enqueue(QImage frame, const size_t index)
+{
+    // The future is not needed, completion is tracked through m_inFlight
+    const bool flip = m_flip;
+    m_encoders.submit([this, frame = std::move(frame), index, flip] {
+        const QString path = pathFor(index);
+        const bool saved = (flip ? frame.mirrored() : frame).save(path, m_format.constData());
+        if (!saved)
+            qDebug() << "Cannot write frame:" << path;
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_inFlight--;
+            if (saved)
+                m_stats.written++;
+            else
+                m_stats.failed++;
+        }
+        m_slotFreed.notify_all();
+    });
+}
+
+void ImageSequenceWriter::finish()
+{
+    std::unique_lock lock(m_mutex);
+    m_slotFreed.wait(lock, [this] { return m_inFlight == 0; });
+}
+
+void ImageSequenceWriter::setFlipVertically(const bool flip)
+{
+    m_flip = flip;
+}
+
+QString ImageSequenceWriter::pathFor(const size_t index) const
+{
+    const QString name = QString("%1_%2.%3")
+        .arg(m_baseName)
+        .arg(static_cast<qulonglong>(index), 5, 10, QChar('0'))
+        .arg(QString::fromLatin1(m_format));
+    return QDir(m_directory).filePath(name);
+}
+
+QString ImageSequenceWriter::directory() const
+{
+    return m_directory;
+}
+
+QByteArray ImageSequenceWriter::format() const
+{
+    return m_format;
+}
+
+size_t ImageSequenceWriter::frameCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_nextFrame;
+}
+
+ImageSequenceWriter::Stats ImageSequenceWriter::stats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
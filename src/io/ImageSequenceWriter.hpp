@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+#include "../core/ThreadPool.hpp"
+
+/**
+ * @brief Writes rendered frames as a numbered image sequence on encoder threads.
+ *
+ * Frames are queued to a private pool and saved with QImage::save as
+ * <directory>/<baseName>_00000.<format>, numbered in submission order. At most
+ * queueCapacity frames wait or encode at a time: write() blocks until a slot
+ * frees up, so an offline render is throttled to the disk instead of buffering
+ * without bound, while tryWrite() drops the frame so an interactive capture
+ * never stalls.
+ *
+ * Formats come from the Qt image plugins. EXR needs an extra plugin (e.g.
+ * KImageFormats); without it the writer falls back to PNG.
+ */
+class ImageSequenceWriter
+{
+public:
+	struct Stats
+	{
+		size_t written = 0;
+		size_t failed = 0;
+		size_t dropped = 0;
+	};
+
+	ImageSequenceWriter(const QString &directory, const QString &baseName, const QByteArray &format = "png",
+						size_t queueCapacity = 8, size_t encoderThreads = 2);
+	~ImageSequenceWriter();
+
+	ImageSequenceWriter(const ImageSequenceWriter &) = delete;
+	ImageSequenceWriter &operator=(const ImageSequenceWriter &) = delete;
+
+	bool write(QImage frame);
+	bool tryWrite(QImage frame);
+
+	// Blocks until every queued frame is on disk
+	void finish();
+
+	// GL readbacks come bottom row first; flipping happens on the encoder threads
+	void setFlipVertically(bool flip);
+
+	QString directory() const;
+	QByteArray format() const;
+	size_t frameCount() const;
+	Stats stats() const;
+
+private:
+	QString m_directory;
+	QString m_baseName;
+	QByteArray m_format;
+	size_t m_capacity;
+	bool m_flip = false;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_slotFreed;
+	size_t m_inFlight = 0;
+	size_t m_nextFrame = 0;
+	Stats m_stats;
+
+	// Last, so its threads are joined before the state they use is destroyed
+	ThreadPool m_encoders;
+
+	void enqueue(QImage frame, size_t index);
+	QString pathFor(size_t index) const;
+};
@@ -0,0 +1,364 @@
+#include "MeshExporter.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr int GL_FLOAT_COMPONENT = 5126;
+    constexpr int GL_UNSIGNED_SHORT_COMPONENT = 5123;
+    constexpr int GL_UNSIGNED_INT_COMPONENT = 5125;
+    constexpr int ARRAY_BUFFER_TARGET = 34962;
+    constexpr int ELEMENT_ARRAY_BUFFER_TARGET = 34963;
+    constexpr int TRIANGLES_MODE = 4;
+
+    static_assert(sizeof(BumperGeometry::Vertex) == 24, "glTF vertex views assume tightly packed position and normal");
+
+    QJsonArray toJson(const glm::vec3 &v)
+    {
+        return QJsonArray { v.x, v.y, v.z };
+    }
+}
+
+MeshExporter::MeshExporter(const QString &path, const size_t chunkBytes)
+    : m_format(QFileInfo(path).suffix().toLower() == "gltf" ? Format::GLTF : Format::OBJ)
+    , m_path(path)
+    , m_chunkBytes(std::max<size_t>(4096, chunkBytes))
+{
+    m_chunk.reserve(m_chunkBytes);
+
+    if (m_format == Format::OBJ)
+    {
+        m_file.setFileName(path);
+        m_ok = m_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        if (m_ok)
+            putText("# Sphere mesh bumpers, one object per pose\n");
+    }
+    else
+    {
+        // The JSON goes out in finish(), once every buffer length is known
+        const QFileInfo info(path);
+        m_binary.setFileName(info.dir().filePath(info.completeBaseName() + ".bin"));
+        m_ok = m_binary.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+
+    if (!m_ok)
+        qDebug() << "Cannot open export file:" << path;
+}
+
+MeshExporter::~MeshExporter()
+{
+    finish();
+}
+
+bool MeshExporter::supports(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "obj" || suffix == "gltf";
+}
+
+bool MeshExporter::isOpen() const
+{
+    return m_ok && !m_finished;
+}
+
+MeshExporter::Format MeshExporter::format() const
+{
+    return m_format;
+}
+
+size_t MeshExporter::poseCount() const
+{
+    return m_poses;
+}
+
+bool MeshExporter::append(const BumperGeometry &geometry, const QString &name)
+{
+    if (!isOpen())
+        return false;
+
+    if (m_format == Format::OBJ)
+        appendOBJ(geometry, name);
+    else
+        appendGLTF(geometry, name);
+
+    m_poses++;
+    return m_ok;
+}
+
+bool MeshExporter::finish()
+{
+    if (m_finished)
+        return m_ok;
+    m_finished = true;
+
+    if (!m_ok)
+        return false;
+
+    if (m_format == Format::OBJ)
+    {
+        flush();
+        m_file.close();
+        return m_ok;
+    }
+
+    flush();
+    m_binary.close();
+    return m_ok && writeGLTF();
+}
+
+void MeshExporter::put(const void *data, const size_t bytes)
+{
+    if (m_chunk.size() + bytes > m_chunkBytes)
+        flush();
+
+    // Anything larger than a chunk goes straight to the file
+    if (bytes > m_chunkBytes)
+    {
+        QFile &sink = m_format == Format::OBJ ? m_file : m_binary;
+        if (sink.write(static_cast<const char*>(data), static_cast<qint64>(bytes)) != static_cast<qint64>(bytes))
+            m_ok = false;
+    }
+    else
+    {
+        const auto *begin = static_cast<const char*>(data);
+        m_chunk.insert(m_chunk.end(), begin, begin + bytes);
+    }
+
+    m_written += bytes;
+}
+
+void MeshExporter::putText(const char *format, ...)
+{
+    char line[256];
+
+    va_list args;
+    va_start(args, format);
+    const int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (length > 0)
+        put(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+}
+
+bool MeshExporter::flush()
+{
+    if (m_chunk.empty())
+        return m_ok;
+
+    QFile &sink = m_format == Format::OBJ ? m_file : m_binary;
+    const auto bytes = static_cast<qint64>(m_chunk.size());
+    if (sink.write(m_chunk.data(), bytes) != bytes)
+    {
+        qDebug() << "Cannot write export file:" << sink.fileName();
+        m_ok = false;
+    }
+    m_chunk.clear();
+    return m_ok;
+}
+
+void MeshExporter::appendOBJ(const BumperGeometry &geometry, const QString &name)
+{
+    putText("o %s\n", name.toUtf8().constData());
+
+    for (size_t s = 0; s < geometry.subMeshes.size(); s++)
+    {
+        const auto &sub = geometry.subMeshes[s];
+        const BumperGeometry::Vertex *vertices = geometry.vertices.data() + sub.baseVertex;
+
+        // Vertex colors are the common "v x y z r g b" extension
+        putText("g %s_%zu\n", name.toUtf8().constData(), s);
+        for (size_t i = 0; i < sub.vertexCount; i++)
+        {
+            const glm::vec3 &p = vertices[i].position;
+            putText("v %.6g %.6g %.6g %.4g %.4g %.4g\n", p.x, p.y, p.z, sub.color.x, sub.color.y, sub.color.z);
+        }
+        for (size_t i = 0; i < sub.vertexCount; i++)
+        {
+            const glm::vec3 &n = vertices[i].normal;
+            putText("vn %.5g %.5g %.5g\n", n.x, n.y, n.z);
+        }
+
+        auto index = [&](const size_t i) -> size_t {
+            const size_t local = sub.wideIndices ? geometry.indices32[sub.indexOffset + i]
+                                                 : geometry.indices16[sub.indexOffset + i];
+            return m_objVertices + local + 1;
+        };
+        for (size_t i = 0; i + 2 < sub.indexCount; i += 3)
+        {
+            const size_t a = index(i), b = index(i + 1), c = index(i + 2);
+            putText("f %zu//%zu %zu//%zu %zu//%zu\n", a, a, b, b, c, c);
+        }
+
+        m_objVertices += sub.vertexCount;
+    }
+}
+
+void MeshExporter::appendGLTF(const BumperGeometry &geometry, const QString &name)
+{
+    QJsonArray primitives;
+
+    for (const auto &sub : geometry.subMeshes)
+    {
+        if (sub.vertexCount == 0 || sub.indexCount == 0)
+            continue;
+
+        const BumperGeometry::Vertex *vertices = geometry.vertices.data() + sub.baseVertex;
+
+        glm::vec3 min(std::numeric_limits<float>::max());
+        glm::vec3 max(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < sub.vertexCount; i++)
+        {
+            min = glm::min(min, vertices[i].position);
+            max = glm::max(max, vertices[i].position);
+        }
+
+        const size_t vertexOffset = m_written;
+        const size_t vertexBytes = sub.vertexCount * sizeof(BumperGeometry::Vertex);
+        put(vertices, vertexBytes);
+        const int vertexView = addBufferView(vertexOffset, vertexBytes, sizeof(BumperGeometry::Vertex),
+                                             ARRAY_BUFFER_TARGET);
+
+        // Submesh indices are relative to baseVertex, which is exactly where the view starts
+        const size_t indexOffset = m_written;
+        const size_t indexBytes = sub.indexCount * (sub.wideIndices ? sizeof(uint32_t) : sizeof(uint16_t));
+        if (sub.wideIndices)
+            put(geometry.indices32.data() + sub.indexOffset, indexBytes);
+        else
+            put(geometry.indices16.data() + sub.indexOffset, indexBytes);
+        const int indexView = addBufferView(indexOffset, indexBytes, 0, ELEMENT_ARRAY_BUFFER_TARGET);
+
+        // The next vertex view must stay 4-byte aligned
+        constexpr char PADDING[4] = {};
+        if (m_written % 4 != 0)
+            put(PADDING, 4 - m_written % 4);
+
+        const int positions = m_accessors.size();
+        m_accessors.append(QJsonObject {
+            { "bufferView", vertexView },
+            { "byteOffset", 0 },
+            { "componentType", GL_FLOAT_COMPONENT },
+            { "count", static_cast<qint64>(sub.vertexCount) },
+            { "type", "VEC3" },
+            { "min", toJson(min) },
+            { "max", toJson(max) },
+        });
+        m_accessors.append(QJsonObject {
+            { "bufferView", vertexView },
+            { "byteOffset", static_cast<int>(offsetof(BumperGeometry::Vertex, normal)) },
+            { "componentType", GL_FLOAT_COMPONENT },
+            { "count", static_cast<qint64>(sub.vertexCount) },
+            { "type", "VEC3" },
+        });
+        m_accessors.append(QJsonObject {
+            { "bufferView", indexView },
+            { "componentType", sub.wideIndices ? GL_UNSIGNED_INT_COMPONENT : GL_UNSIGNED_SHORT_COMPONENT },
+            { "count", static_cast<qint64>(sub.indexCount) },
+            { "type", "SCALAR" },
+        });
+
+        primitives.append(QJsonObject {
+            { "attributes", QJsonObject { { "POSITION", positions }, { "NORMAL", positions + 1 } } },
+            { "indices", positions + 2 },
+            { "material", materialFor(sub.color) },
+            { "mode", TRIANGLES_MODE },
+        });
+    }
+
+    // Every pose is a node at the origin; consumers pick the ones they need by name.
+    // A mesh needs at least one primitive, so an empty pose stays an empty node.
+    QJsonObject node { { "name", name } };
+    if (!primitives.isEmpty())
+    {
+        node.insert("mesh", m_meshes.size());
+        m_meshes.append(QJsonObject { { "name", name }, { "primitives", primitives } });
+    }
+    m_nodes.append(node);
+}
+
+int MeshExporter::materialFor(const glm::vec3 &color)
+{
+    const std::array<float, 3> key { color.x, color.y, color.z };
+    const auto found = m_materialIndex.find(key);
+    if (found != m_materialIndex.end())
+        return found->second;
+
+    const int index = m_materials.size();
+    m_materials.append(QJsonObject {
+        { "pbrMetallicRoughness", QJsonObject {
+            { "baseColorFactor", QJsonArray { color.x, color.y, color.z, 1.0 } },
+            { "metallicFactor", 0.0 },
+            { "roughnessFactor", 1.0 },
+        } },
+    });
+    m_materialIndex.emplace(key, index);
+    return index;
+}
+
+int MeshExporter::addBufferView(const size_t offset, const size_t bytes, const size_t stride, const int target)
+{
+    QJsonObject view {
+        { "buffer", 0 },
+        { "byteOffset", static_cast<qint64>(offset) },
+        { "byteLength", static_cast<qint64>(bytes) },
+        { "target", target },
+    };
+    if (stride != 0)
+        view.insert("byteStride", static_cast<int>(stride));
+
+    const int index = m_bufferViews.size();
+    m_bufferViews.append(view);
+    return index;
+}
+
+bool MeshExporter::writeGLTF()
+{
+    QJsonArray sceneNodes;
+    for (int i = 0; i < m_nodes.size(); i++)
+        sceneNodes.append(i);
+
+    QJsonObject root {
+        { "asset", QJsonObject { { "version", "2.0" }, { "generator", "SMRayTracingRenderer" } } },
+        { "scene", 0 },
+        { "scenes", QJsonArray { QJsonObject { { "nodes", sceneNodes } } } },
+        { "nodes", m_nodes },
+    };
+
+    // glTF rejects empty buffers, so a file without geometry leaves them out
+    if (m_written > 0)
+    {
+        root.insert("meshes", m_meshes);
+        root.insert("materials", m_materials);
+        root.insert("buffers", QJsonArray { QJsonObject {
+            { "uri", QFileInfo(m_binary.fileName()).fileName() },
+            { "byteLength", static_cast<qint64>(m_written) },
+        } });
+        root.insert("bufferViews", m_bufferViews);
+        root.insert("accessors", m_accessors);
+    }
+
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot open export file:" << m_path;
+        return m_ok = false;
+    }
+
+    const QByteArray json = QJsonDocument(root).toJson();
+    m_ok = m_file.write(json) == json.size();
+    m_file.close();
+
+    if (!m_ok)
+        qDebug() << "Cannot write export file:" << m_path;
+    return m_ok;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QFile>
+#include <QJsonArray>
+#include <QString>
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "../geometry/BumperGeometry.hpp"
+
+/**
+ * @brief Streams tessellated bumper geometry to OBJ or glTF, one pose at a time.
+ *
+ * Every append() adds one pose as its own object (OBJ) or mesh and node
+ * (glTF), with a group or primitive per submesh. Vertex and index data go
+ * through a buffer of chunkBytes and are flushed to disk as it fills, so
+ * exporting a long trajectory never holds more than the current pose.
+ *
+ * glTF output is a .gltf with a .bin next to it. Only the JSON describing the
+ * accessors is kept until finish(), since glTF needs the buffer length up
+ * front.
+ */
+class MeshExporter
+{
+public:
+	enum class Format
+	{
+		OBJ,
+		GLTF
+	};
+
+	static constexpr size_t DEFAULT_CHUNK_BYTES = 4u << 20;
+
+	explicit MeshExporter(const QString &path, size_t chunkBytes = DEFAULT_CHUNK_BYTES);
+	~MeshExporter();
+
+	MeshExporter(const MeshExporter &) = delete;
+	MeshExporter &operator=(const MeshExporter &) = delete;
+
+	// The format follows the suffix, .obj or .gltf
+	static bool supports(const QString &path);
+
+	bool isOpen() const;
+	bool append(const BumperGeometry &geometry, const QString &name);
+	bool finish();
+
+	Format format() const;
+	size_t poseCount() const;
+
+private:
+	Format m_format;
+	QString m_path;
+	QFile m_file;
+	QFile m_binary;
+	size_t m_chunkBytes;
+	std::vector<char> m_chunk;
+	bool m_ok = false;
+	bool m_finished = false;
+
+	size_t m_poses = 0;
+	size_t m_written = 0;
+
+	// OBJ indices are global and 1-based
+	size_t m_objVertices = 0;
+
+	// glTF document, written out by finish()
+	QJsonArray m_bufferViews;
+	QJsonArray m_accessors;
+	QJsonArray m_meshes;
+	QJsonArray m_nodes;
+	QJsonArray m_materials;
+	std::map<std::array<float, 3>, int> m_materialIndex;
+
+	void put(const void *data, size_t bytes);
+	void putText(const char *format, ...);
+	bool flush();
+
+	void appendOBJ(const BumperGeometry &geometry, const QString &name);
+	void appendGLTF(const BumperGeometry &geometry, const QString &name);
+	int materialFor(const glm::vec3 &color);
+	int addBufferView(size_t offset, size_t bytes, size_t stride, int target);
+	bool writeGLTF();
+};
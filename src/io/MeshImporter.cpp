@@ -0,0 +1,82 @@
+#include "MeshImporter.hpp"
+
+#include <QDebug>
+
+#include <assimp/Importer.hpp>
+#include <assimp/material.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+bool MeshImporter::load(const QString &path, BumperGeometry &out)
+{
+    out.clear();
+
+    Assimp::Importer importer;
+    const aiScene *scene = importer.ReadFile(path.toStdString(),
+                                             aiProcess_Triangulate | aiProcess_JoinIdenticalVertices |
+                                             aiProcess_GenSmoothNormals | aiProcess_PreTransformVertices |
+                                             aiProcess_SortByPType);
+    if (!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !scene->mRootNode)
+    {
+        qDebug() << "Cannot import mesh:" << path << importer.GetErrorString();
+        return false;
+    }
+
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+    {
+        const aiMesh *mesh = scene->mMeshes[m];
+
+        // Points and lines are split off by SortByPType and have nothing to trace
+        if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) || mesh->mNumVertices == 0)
+            continue;
+
+        BumperGeometry::SubMesh sub {};
+        sub.baseVertex = out.vertices.size();
+        sub.vertexCount = mesh->mNumVertices;
+        sub.wideIndices = sub.vertexCount > BumperGeometry::MAX_SHORT_VERTICES;
+        sub.indexOffset = sub.wideIndices ? out.indices32.size() : out.indices16.size();
+        sub.color = glm::vec3(0.7f);
+
+        aiColor4D diffuse;
+        if (mesh->mMaterialIndex < scene->mNumMaterials &&
+            aiGetMaterialColor(scene->mMaterials[mesh->mMaterialIndex], AI_MATKEY_COLOR_DIFFUSE, &diffuse) == AI_SUCCESS)
+            sub.color = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+
+        for (unsigned int v = 0; v < mesh->mNumVertices; v++)
+        {
+            const aiVector3D &p = mesh->mVertices[v];
+            const glm::vec3 normal = mesh->HasNormals()
+                ? glm::vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z)
+                : glm::vec3(0.0f, 1.0f, 0.0f);
+            out.vertices.push_back({ glm::vec3(p.x, p.y, p.z), normal });
+        }
+
+        for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+        {
+            const aiFace &face = mesh->mFaces[f];
+            if (face.mNumIndices != 3)
+                continue;
+
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                if (sub.wideIndices)
+                    out.indices32.push_back(face.mIndices[k]);
+                else
+                    out.indices16.push_back(static_cast<uint16_t>(face.mIndices[k]));
+            }
+            sub.indexCount += 3;
+        }
+
+        out.subMeshes.push_back(sub);
+    }
+
+    if (out.subMeshes.empty())
+    {
+        qDebug() << "No triangles in" << path;
+        return false;
+    }
+
+    qDebug() << "Imported" << path << ":" << out.vertices.size() << "vertices," << out.indexCount() / 3
+             << "triangles";
+    return true;
+}
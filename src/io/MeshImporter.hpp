@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QString>
+
+#include "../geometry/BumperGeometry.hpp"
+
+/**
+ * @brief Imports triangle meshes (props, sets) through Assimp.
+ *
+ * The scene graph is flattened with its node transforms applied, and every
+ * Assimp mesh becomes one submesh colored by its material's diffuse color.
+ * The result uses the bumper vertex layout so it can be drawn by BumperMesh
+ * and traced through a TriangleBVH. No GL calls are made.
+ */
+class MeshImporter
+{
+public:
+	static bool load(const QString &path, BumperGeometry &out);
+};
@@ -0,0 +1,397 @@
+#include "SphereMeshFile.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+
+using namespace SM;
+using namespace SM::Graph;
+
+// Files are written in host order and documented as little-endian
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "sphere mesh files assume a little-endian host");
+
+namespace
+{
+    constexpr char MAGIC[4] = { 'S', 'M', 'B', 'N' };
+    constexpr uint32_t VERSION = 1;
+
+    uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool writePadding(QFile &file, const uint64_t target)
+    {
+        static const char zeros[SphereSoA::ALIGNMENT] = {};
+        qint64 missing = static_cast<qint64>(target) - file.pos();
+        while (missing > 0)
+        {
+            const qint64 count = std::min<qint64>(missing, sizeof(zeros));
+            if (file.write(zeros, count) != count)
+                return false;
+            missing -= count;
+        }
+        return true;
+    }
+
+    template <typename T>
+    T toShape(const SphereMeshFile::BumperRecord &record)
+    {
+        T shape {};
+        for (size_t c = 0; c < std::extent_v<decltype(shape.sphereIndex)>; c++)
+            shape.sphereIndex[c] = static_cast<int>(record.sphereIndex[c]);
+        return shape;
+    }
+
+    float &component(Sphere &sphere, const int c)
+    {
+        return c < 3 ? sphere.center[c] : sphere.radius;
+    }
+
+    float component(const Sphere &sphere, const int c)
+    {
+        return c < 3 ? sphere.center[c] : sphere.radius;
+    }
+}
+
+bool SphereMeshFile::write(const BumperGraph &graph, const QString &path, const size_t chunkBytes)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot write sphere mesh:" << path << file.errorString();
+        return false;
+    }
+
+    const size_t count = graph.sphere.size();
+    const size_t paddedCount = (count + SphereSoA::LANES - 1) / SphereSoA::LANES * SphereSoA::LANES;
+
+    Header header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sphereCount = static_cast<uint32_t>(count);
+    header.paddedCount = static_cast<uint32_t>(paddedCount);
+    header.bumperCount = graph.bumper.size();
+    header.sphereOffset = SphereSoA::ALIGNMENT;
+    header.bumperOffset = header.sphereOffset + 4 * paddedCount * sizeof(float);
+    header.fileSize = header.bumperOffset + graph.bumper.size() * sizeof(BumperRecord);
+
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header);
+    ok = ok && writePadding(file, header.sphereOffset);
+
+    // Each component array is gathered from the graph one chunk at a time
+    const size_t sphereChunk = std::max<size_t>(1, chunkBytes / sizeof(float));
+    std::vector<float> values;
+    values.reserve(std::min(sphereChunk, count));
+
+    for (int c = 0; ok && c < 4; c++)
+    {
+        for (size_t first = 0; ok && first < count; first += sphereChunk)
+        {
+            const size_t last = std::min(count, first + sphereChunk);
+            values.clear();
+            for (size_t i = first; i < last; i++)
+                values.push_back(component(graph.sphere[i], c));
+
+            const auto bytes = static_cast<qint64>(values.size() * sizeof(float));
+            ok = file.write(reinterpret_cast<const char*>(values.data()), bytes) == bytes;
+        }
+        ok = ok && writePadding(file, header.sphereOffset + (c + 1) * paddedCount * sizeof(float));
+    }
+
+    const size_t recordChunk = std::max<size_t>(1, chunkBytes / sizeof(BumperRecord));
+    std::vector<BumperRecord> records;
+    records.reserve(std::min(recordChunk, graph.bumper.size()));
+
+    for (size_t first = 0; ok && first < graph.bumper.size(); first += recordChunk)
+    {
+        const size_t last = std::min(graph.bumper.size(), first + recordChunk);
+        records.clear();
+        for (size_t i = first; i < last; i++)
+            records.push_back(toRecord(graph.bumper[i]));
+
+        const auto bytes = static_cast<qint64>(records.size() * sizeof(BumperRecord));
+        ok = file.write(reinterpret_cast<const char*>(records.data()), bytes) == bytes;
+    }
+
+    if (!ok)
+    {
+        qDebug() << "Error while writing sphere mesh:" << path << file.errorString();
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+bool SphereMeshFile::read(const QString &path, BumperGraph &graph, const size_t chunkBytes,
+                          const ProgressCallback &progress)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Cannot open sphere mesh:" << path << file.errorString();
+        return false;
+    }
+
+    Header header {};
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(Header)) != sizeof(Header) ||
+        !isValid(header, static_cast<uint64_t>(file.size())))
+    {
+        qDebug() << "Not a valid sphere mesh:" << path;
+        return false;
+    }
+
+    const size_t count = header.sphereCount;
+    const double total = static_cast<double>(4 * count + header.bumperCount);
+    double done = 0.0;
+    auto advance = [&](const size_t amount) {
+        done += static_cast<double>(amount);
+        if (progress && total > 0.0)
+            progress(static_cast<float>(done / total));
+    };
+
+    // Allocate the final arrays once, then fill them through a small buffer
+    graph.sphere.assign(count, Sphere {});
+    graph.bumper.clear();
+    graph.bumper.reserve(header.bumperCount);
+
+    const size_t sphereChunk = std::max<size_t>(1, chunkBytes / sizeof(float));
+    std::vector<float> values(std::min(sphereChunk, count));
+
+    for (int c = 0; c < 4; c++)
+    {
+        if (!file.seek(static_cast<qint64>(header.sphereOffset + c * header.paddedCount * sizeof(float))))
+            return false;
+
+        for (size_t first = 0; first < count; first += sphereChunk)
+        {
+            const size_t n = std::min(sphereChunk, count - first);
+            const auto bytes = static_cast<qint64>(n * sizeof(float));
+            if (file.read(reinterpret_cast<char*>(values.data()), bytes) != bytes)
+            {
+                qDebug() << "Sphere mesh is truncated:" << path;
+                return false;
+            }
+
+            for (size_t i = 0; i < n; i++)
+                component(graph.sphere[first + i], c) = values[i];
+            advance(n);
+        }
+    }
+
+    const size_t recordChunk = std::max<size_t>(1, chunkBytes / sizeof(BumperRecord));
+    std::vector<BumperRecord> records(std::min<size_t>(recordChunk, header.bumperCount));
+
+    if (!file.seek(static_cast<qint64>(header.bumperOffset)))
+        return false;
+
+    for (size_t first = 0; first < header.bumperCount; first += recordChunk)
+    {
+        const size_t n = std::min<size_t>(recordChunk, header.bumperCount - first);
+        const auto bytes = static_cast<qint64>(n * sizeof(BumperRecord));
+        if (file.read(reinterpret_cast<char*>(records.data()), bytes) != bytes)
+        {
+            qDebug() << "Sphere mesh is truncated:" << path;
+            return false;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!isValid(records[i], count))
+            {
+                qDebug() << "Sphere mesh has an invalid bumper:" << path << "record" << first + i;
+                return false;
+            }
+            graph.bumper.push_back(fromRecord(records[i]));
+        }
+        advance(n);
+    }
+
+    return true;
+}
+
+SphereMeshFile::~SphereMeshFile()
+{
+    close();
+}
+
+bool SphereMeshFile::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Cannot open sphere mesh:" << path << m_file.errorString();
+        return false;
+    }
+
+    if (m_file.size() < static_cast<qint64>(sizeof(Header)))
+    {
+        qDebug() << "Sphere mesh is truncated:" << path;
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_file.size());
+    if (!m_data)
+    {
+        qDebug() << "Cannot map sphere mesh:" << path << m_file.errorString();
+        close();
+        return false;
+    }
+
+    std::memcpy(&m_header, m_data, sizeof(Header));
+
+    // The mapping is page aligned, so the offsets decide whether the arrays can be read in place
+    if (!isValid(m_header, static_cast<uint64_t>(m_file.size())) ||
+        m_header.bumperOffset % alignof(BumperRecord) != 0)
+    {
+        qDebug() << "Not a valid sphere mesh:" << path;
+        close();
+        return false;
+    }
+
+    // Checked once here, so bumpers() can be handed out without further checks
+    const BumperRecord* records = bumpers();
+    for (size_t i = 0; i < m_header.bumperCount; i++)
+    {
+        if (!isValid(records[i], m_header.sphereCount))
+        {
+            qDebug() << "Sphere mesh has an invalid bumper:" << path << "record" << i;
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SphereMeshFile::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_header = {};
+
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool SphereMeshFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+size_t SphereMeshFile::sphereCount() const
+{
+    return m_header.sphereCount;
+}
+
+size_t SphereMeshFile::bumperCount() const
+{
+    return m_header.bumperCount;
+}
+
+SphereMeshFile::SphereView SphereMeshFile::spheres() const
+{
+    const size_t padded = m_header.paddedCount;
+    const auto* block = reinterpret_cast<const float*>(m_data + m_header.sphereOffset);
+
+    SphereView view {};
+    view.x = block;
+    view.y = block + padded;
+    view.z = block + 2 * padded;
+    view.r = block + 3 * padded;
+    view.count = m_header.sphereCount;
+    return view;
+}
+
+const SphereMeshFile::BumperRecord* SphereMeshFile::bumpers() const
+{
+    return reinterpret_cast<const BumperRecord*>(m_data + m_header.bumperOffset);
+}
+
+void SphereMeshFile::copyTo(BumperGraph &graph, const ProgressCallback &progress) const
+{
+    const SphereView view = spheres();
+    const BumperRecord* records = bumpers();
+
+    graph.sphere.resize(view.count);
+    for (size_t i = 0; i < view.count; i++)
+    {
+        graph.sphere[i].center = glm::vec3(view.x[i], view.y[i], view.z[i]);
+        graph.sphere[i].radius = view.r[i];
+    }
+    if (progress)
+        progress(0.5f);
+
+    graph.bumper.clear();
+    graph.bumper.reserve(m_header.bumperCount);
+    for (size_t i = 0; i < m_header.bumperCount; i++)
+        graph.bumper.push_back(fromRecord(records[i]));
+    if (progress)
+        progress(1.0f);
+}
+
+bool SphereMeshFile::isValid(const Header &header, const uint64_t fileSize)
+{
+    // Every field is untrusted: bound each section by the file before relying on the next
+    const uint64_t sphereBytes = 4ull * header.paddedCount * sizeof(float);
+    return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION &&
+           header.fileSize <= fileSize &&
+           header.sphereOffset % SphereSoA::ALIGNMENT == 0 &&
+           header.paddedCount >= header.sphereCount &&
+           header.sphereOffset <= header.fileSize &&
+           sphereBytes <= header.fileSize - header.sphereOffset &&
+           header.bumperOffset >= header.sphereOffset + sphereBytes &&
+           header.bumperOffset <= header.fileSize &&
+           header.bumperCount <= (header.fileSize - header.bumperOffset) / sizeof(BumperRecord);
+}
+
+bool SphereMeshFile::isValid(const BumperRecord &record, const size_t sphereCount)
+{
+    size_t corners = 0;
+    switch (record.type)
+    {
+    case Bumper::CAPSULOID: corners = 2; break;
+    case Bumper::PRYSMOID: corners = 3; break;
+    case Bumper::QUAD: corners = 4; break;
+    default: return false;
+    }
+
+    return std::all_of(record.sphereIndex, record.sphereIndex + corners, [sphereCount](const uint32_t index) {
+        return index < sphereCount;
+    });
+}
+
+SphereMeshFile::BumperRecord SphereMeshFile::toRecord(const Bumper &bumper)
+{
+    BumperRecord record {};
+    record.type = static_cast<uint32_t>(bumper.shapeType);
+    std::visit([&record](const auto &shape) {
+        constexpr size_t corners = std::extent_v<decltype(shape.sphereIndex)>;
+        for (size_t c = 0; c < corners; c++)
+            record.sphereIndex[c] = static_cast<uint32_t>(shape.sphereIndex[c]);
+    }, bumper.bumper);
+    return record;
+}
+
+Bumper SphereMeshFile::fromRecord(const BumperRecord &record)
+{
+    Bumper b {};
+    b.shapeType = static_cast<decltype(b.shapeType)>(record.type);
+    if (b.shapeType == Bumper::PRYSMOID)
+        b.bumper = toShape<BumperPrysmoid>(record);
+    else if (b.shapeType == Bumper::QUAD)
+        b.bumper = toShape<BumperQuad>(record);
+    else
+        b.bumper = toShape<BumperCapsuloid>(record);
+    return b;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "bumper_graph.h"
+#include "../geometry/SphereSoA.hpp"
+
+/**
+ * @brief Binary sphere mesh (.smb).
+ *
+ * The file holds a fixed header, the rest pose spheres as x, y, z and r
+ * arrays laid out like SphereSoA (64-byte aligned, padded to
+ * SphereSoA::LANES), then one record per bumper in graph order. All values are
+ * little-endian.
+ *
+ * open() maps the file and validates it without parsing: spheres() and
+ * bumpers() then point straight into the mapping, and copyTo() fills a graph
+ * from it with no staging buffer. The pages belong to the file, so a mesh of
+ * millions of spheres costs little more than the graph itself.
+ *
+ * read() and write() stream the file through a buffer of chunkBytes instead,
+ * for files that cannot be mapped. Both read paths check every section against
+ * the file size and every bumper record against the sphere count, so a corrupt
+ * file is rejected instead of handing out-of-range sphere indices to the graph.
+ *
+ * Files are written from a constructed BumperGraph, see tools/smconvert.
+ * Blend shapes stay in the .sm file, the library keeps them private.
+ */
+class SphereMeshFile
+{
+public:
+	struct BumperRecord {
+		uint32_t type;
+		uint32_t sphereIndex[4];
+	};
+
+	struct SphereView {
+		const float* x;
+		const float* y;
+		const float* z;
+		const float* r;
+		size_t count;
+	};
+
+	static constexpr size_t DEFAULT_CHUNK_BYTES = 4u << 20;
+
+	using ProgressCallback = std::function<void(float progress)>;
+
+	SphereMeshFile() = default;
+	~SphereMeshFile();
+
+	SphereMeshFile(const SphereMeshFile &) = delete;
+	SphereMeshFile &operator=(const SphereMeshFile &) = delete;
+
+	bool open(const QString &path);
+	void close();
+	bool isOpen() const;
+
+	size_t sphereCount() const;
+	size_t bumperCount() const;
+
+	// Valid until close(); the arrays are padded to the header's padded count
+	SphereView spheres() const;
+	const BumperRecord* bumpers() const;
+
+	void copyTo(SM::Graph::BumperGraph &graph, const ProgressCallback &progress = {}) const;
+
+	static bool write(const SM::Graph::BumperGraph &graph, const QString &path,
+					  size_t chunkBytes = DEFAULT_CHUNK_BYTES);
+	static bool read(const QString &path, SM::Graph::BumperGraph &graph,
+					 size_t chunkBytes = DEFAULT_CHUNK_BYTES, const ProgressCallback &progress = {});
+
+	static BumperRecord toRecord(const SM::Graph::Bumper &bumper);
+	static SM::Graph::Bumper fromRecord(const BumperRecord &record);
+
+	// A known type whose corners all index one of sphereCount spheres
+	static bool isValid(const BumperRecord &record, size_t sphereCount);
+
+private:
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t sphereCount;
+		uint32_t paddedCount;
+		uint64_t bumperCount;
+		uint64_t sphereOffset;
+		uint64_t bumperOffset;
+		uint64_t fileSize;
+		uint8_t reserved[16];
+	};
+	static_assert(sizeof(Header) == 64, "sphere mesh header must stay 64 bytes");
+	static_assert(sizeof(BumperRecord) == 20, "bumper records are written as five uint32");
+
+	static bool isValid(const Header &header, uint64_t fileSize);
+
+	QFile m_file;
+	const uchar* m_data = nullptr;
+	Header m_header {};
+};
@@ -1,63 +1,73 @@
 #pragma once
 #include "bumper_graph.h"
+#include "BumperMesh.hpp"
+#include "FrameProfiler.hpp"
+#include "GeometryCache.hpp"
+#include "GeometryWorker.hpp"
+#include "MemoryReport.hpp"
 #include "Shader.hpp"
+#include "../geometry/BumperGeometryBuilder.hpp"
+#include "../geometry/SphereSoA.hpp"
 
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLBuffer>
 #include <QOpenGLShaderProgram>
 
+#include <memory>
+#include <optional>
+
 class BumperGraphRenderer
 {
 public:
-	explicit BumperGraphRenderer(const SM::Graph::BumperGraph* bumper_graph);
+	// Geometry built elsewhere for the current spheres is taken over instead of rebuilt
+	BumperGraphRenderer(const SM::Graph::BumperGraph* bumper_graph, BumperBuckets buckets,
+						BumperGeometry *geometry = nullptr);
 
 	void setSphereShader(Shader* shdr);
 	void setBumperShader(Shader* shdr);
 
 	glm::vec3 getCentroid() const;
 
+	void setGeometryCache(GeometryCache* cache);
+	void setProfiler(FrameProfiler* profiler);
+	// The mesh on screen: the live mesh, or a cache entry for a cached pose
+	std::shared_ptr<BumperMesh> mesh() const;
+
 	void render();
 	void update();
+	void update(const PoseKey &key);
+	// Swaps the frame's buffers with ours, so the worker gets our previous ones back to patch
+	void present(GeometryWorker::Frame &frame);
+
+	// Copies the live mesh into the cache under key, unless the key is cached already
+	void cacheSnapshot(const PoseKey &key);
+
+	const SphereSoA &sphereSoA() const;
+
+	void reportMemory(MemoryReport &report) const;
 
 private:
 	Shader* sphereShader;
 	Shader* bumperShader;
 	const SM::Graph::BumperGraph* bg;
+	GeometryCache* m_cache = nullptr;
+	FrameProfiler* m_profiler = nullptr;
+	BumperGeometryBuilder m_builder;
 
-	struct Vertex {
-		glm::vec3 position;
-		glm::vec3 normal;
-	};
-	std::vector<Vertex> m_vertices;
-	std::vector<unsigned int> m_indices;
-
-	struct SubMesh {
-		size_t indexOffset;
-		size_t indexCount;
-		glm::vec3 color;
-	};
-	std::vector<SubMesh> m_subMeshes;
+	std::vector<SM::Sphere> m_spheres;
+	SphereSoA m_soa;
+	// Built into and patched in place; never shared with the cache, which gets copies
+	std::shared_ptr<BumperMesh> m_live;
+	std::shared_ptr<BumperMesh> m_mesh;
 
-	QOpenGLVertexArrayObject m_VAO;
-	QOpenGLBuffer m_VBO { QOpenGLBuffer::VertexBuffer };
-	QOpenGLBuffer m_EBO { QOpenGLBuffer::IndexBuffer };
+	// Worker pose generations of m_spheres and of m_live's geometry, 0 when built here
+	uint64_t m_sphereGeneration = 0;
+	uint64_t m_meshGeneration = 0;
 
 	void renderSpheres() const;
 	void renderSphere(const glm::vec3 &center, float radius, const glm::vec3 &color) const;
 
-	static glm::vec3 computeUpperPlaneNormal(
-		const SM::Sphere &sa,
-		const SM::Sphere &sb,
-		const SM::Sphere &sc,
-		int direction);
-
-	void buildPrysmoidGeometry(int index, const glm::vec3 &color);
-	void buildQuadGeometry(int index, const glm::vec3 &color);
-	void buildCapsuloidGeometry(int index, const glm::vec3 &color);
-	void buildCapsuleBetweenSpheres(int sphereIndex1, int sphereIndex2,
-									const glm::vec3& color);
-
-	void appendTriangle(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3,
-						const glm::vec3& n1, const glm::vec3& n2, const glm::vec3& n3);
+	BumperMesh &liveMesh();
+	void adoptGeometry(BumperGeometry &geometry, uint64_t &generation);
 	void uploadGeometryToGPU();
 };
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "BumperMesh.hpp"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+size_t BumperMesh::gpuBytes() const
+{
+    return vertexBufferBytes + indexBufferBytes;
+}
+
+void BumperMesh::upload()
+{
+    if (!vao.isCreated()) {
+        vao.create();
+    }
+    vao.bind();
+
+    if (!vbo.isCreated()) {
+        vbo.create();
+    }
+    vbo.bind();
+    vertexBufferBytes = vertices.size() * sizeof(Vertex);
+    vbo.allocate(vertices.data(), static_cast<int>(vertexBufferBytes));
+
+    if (!ebo.isCreated()) {
+        ebo.create();
+    }
+    ebo.bind();
+
+    const size_t shortBytes = indices16.size() * sizeof(uint16_t);
+    const size_t wideBytes = indices32.size() * sizeof(uint32_t);
+    wideIndexByteOffset = (shortBytes + 3) & ~static_cast<size_t>(3);
+    indexBufferBytes = wideIndexByteOffset + wideBytes;
+
+    ebo.allocate(static_cast<int>(indexBufferBytes));
+    if (shortBytes > 0)
+        ebo.write(0, indices16.data(), static_cast<int>(shortBytes));
+    if (wideBytes > 0)
+        ebo.write(static_cast<int>(wideIndexByteOffset), indices32.data(), static_cast<int>(wideBytes));
+
+    bindVertexAttributes(0);
+
+    vao.release();
+    vbo.release();
+    ebo.release();
+}
+
+void BumperMesh::bindVertexAttributes(const size_t baseVertex) const
+{
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+
+    const size_t base = baseVertex * sizeof(Vertex);
+
+    f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                             reinterpret_cast<void*>(base + offsetof(Vertex, position)));
+    f->glEnableVertexAttribArray(0);
+
+    f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                             reinterpret_cast<void*>(base + offsetof(Vertex, normal)));
+    f->glEnableVertexAttribArray(1);
+}
+
+unsigned int BumperMesh::indexType(const SubMesh &sub) const
+{
+    return sub.wideIndices ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+
+const void *BumperMesh::indexOffset(const SubMesh &sub) const
+{
+    const size_t offsetBytes = sub.wideIndices
+        ? wideIndexByteOffset + sub.indexOffset * sizeof(uint32_t)
+        : sub.indexOffset * sizeof(uint16_t);
+    return reinterpret_cast<const void*>(offsetBytes);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QOpenGLBuffer>
+#include <QOpenGLVertexArrayObject>
+
+#include "../geometry/BumperGeometry.hpp"
+
+/**
+ * @brief Tessellated bumper geometry for a single pose together with the GPU
+ *        buffers it has been uploaded to.
+ *
+ * Meshes are handed around through shared pointers so that the geometry cache
+ * can keep previously built poses alive while the renderer draws another one.
+ */
+struct BumperMesh : BumperGeometry
+{
+	QOpenGLVertexArrayObject vao;
+	QOpenGLBuffer vbo { QOpenGLBuffer::VertexBuffer };
+	QOpenGLBuffer ebo { QOpenGLBuffer::IndexBuffer };
+
+	// Index buffer layout: 16-bit indices, padding to 4 bytes, 32-bit indices
+	size_t wideIndexByteOffset = 0;
+
+	size_t vertexBufferBytes = 0;
+	size_t indexBufferBytes = 0;
+
+	size_t gpuBytes() const;
+
+	// Expects the GL context the buffers belong to to be current
+	void upload();
+	void bindVertexAttributes(size_t baseVertex) const;
+	unsigned int indexType(const SubMesh &sub) const;
+	const void *indexOffset(const SubMesh &sub) const;
+};
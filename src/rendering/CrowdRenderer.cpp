@@ -0,0 +1,415 @@
+#include "CrowdRenderer.hpp"
+
+#include <QDebug>
+#include <QOpenGLFunctions>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#include "glm/ext/matrix_transform.hpp"
+#include "../io/AssetCache.hpp"
+
+using namespace SM;
+using namespace SM::Graph;
+
+CrowdRenderer::CrowdRenderer(const BumperGraph &rest, BumperBuckets buckets, const float quantum, ThreadPool &pool)
+    : m_evaluator(rest, pool)
+    , m_builder(std::move(buckets))
+    , m_pool(pool)
+    , m_quantum(quantum)
+{
+}
+
+CrowdRenderer::~CrowdRenderer()
+{
+    if (m_buildTask.valid())
+        m_buildTask.wait();
+}
+
+PoseKey CrowdRenderer::keyFor(const Pose &pose) const
+{
+    return {
+        static_cast<int>(std::lround(pose.alpha / m_quantum)),
+        static_cast<int>(std::lround(pose.beta / m_quantum))
+    };
+}
+
+bool CrowdRenderer::isBuilding(const PoseKey &key) const
+{
+    if (!m_buildTask.valid())
+        return false;
+
+    return std::any_of(m_built.begin(), m_built.end(), [&](const BuiltPose &built) {
+        return built.key == key;
+    });
+}
+
+void CrowdRenderer::setInstances(std::vector<CrowdInstance> instances)
+{
+    m_instances = std::move(instances);
+    m_pending.clear();
+
+    std::unordered_map<PoseKey, PoseGroup, PoseKeyHash> groups;
+    for (uint32_t i = 0; i < m_instances.size(); i++)
+    {
+        const PoseKey key = keyFor(m_instances[i].pose);
+
+        auto it = groups.find(key);
+        if (it == groups.end())
+        {
+            it = groups.emplace(key, PoseGroup{}).first;
+
+            // Keep what was already built for this pose
+            const auto previous = m_groups.find(key);
+            if (previous != m_groups.end() && previous->second.mesh)
+            {
+                it->second.mesh = std::move(previous->second.mesh);
+                it->second.blas = std::move(previous->second.blas);
+            }
+            else if (!isBuilding(key))
+                m_pending.push_back(key);
+        }
+        it->second.instances.push_back(i);
+    }
+
+    m_groups = std::move(groups);
+    invalidateLayout();
+}
+
+const std::vector<CrowdInstance> &CrowdRenderer::instances() const
+{
+    return m_instances;
+}
+
+void CrowdRenderer::setMaxPosesPerUpdate(const size_t count)
+{
+    m_maxPosesPerUpdate = count;
+}
+
+void CrowdRenderer::setRestSource(const QString &path)
+{
+    m_restSource = path;
+}
+
+void CrowdRenderer::setProps(std::vector<const Prop*> props)
+{
+    m_props = std::move(props);
+    invalidateLayout();
+}
+
+size_t CrowdRenderer::poseCount() const
+{
+    return m_groups.size();
+}
+
+bool CrowdRenderer::isReady() const
+{
+    return m_pending.empty() && !m_buildTask.valid();
+}
+
+bool CrowdRenderer::isInstanced() const
+{
+    return m_vertexAttribDivisor && m_drawElementsInstanced;
+}
+
+void CrowdRenderer::update()
+{
+    if (m_buildTask.valid() && m_buildTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        m_buildTask.get();
+        installBuilt();
+    }
+
+    buildPending();
+
+    if (m_layoutDirty)
+        rebuildLayout();
+}
+
+void CrowdRenderer::buildPending()
+{
+    if (m_pending.empty() || m_buildTask.valid())
+        return;
+
+    const size_t count = m_maxPosesPerUpdate > 0 ? std::min(m_pending.size(), m_maxPosesPerUpdate)
+                                                 : m_pending.size();
+    m_built.resize(count);
+    for (size_t i = 0; i < count; i++)
+        m_built[i].key = m_pending[i];
+    m_pending.erase(m_pending.begin(), m_pending.begin() + count);
+
+    m_buildTask = m_pool.submit([this] { buildBatch(); });
+}
+
+void CrowdRenderer::buildBatch()
+{
+    // Evaluate the pose the key stands for, so every instance of the group shares it
+    std::vector<Pose> poses;
+    poses.reserve(m_built.size());
+    for (const auto &built : m_built)
+        poses.push_back({ built.key.alpha * m_quantum, built.key.beta * m_quantum });
+
+    m_evaluator.evaluate(poses, m_posed);
+
+    for (size_t i = 0; i < m_built.size(); i++)
+    {
+        BuiltPose &built = m_built[i];
+        const SphereSoA &soa = m_posed[i];
+
+        if (built.key == PoseKey {})
+            buildRestBlas(built.blas);
+        else
+            built.blas.build(soa);
+
+        m_spheres.resize(soa.size());
+        for (size_t s = 0; s < soa.size(); s++)
+            m_spheres[s] = soa.sphere(s);
+
+        // No GL here: the buffers are created by the upload in installBuilt()
+        built.mesh = std::make_shared<BumperMesh>();
+        m_builder.build(m_spheres, *built.mesh);
+    }
+}
+
+void CrowdRenderer::buildRestBlas(SphereBVH &blas) const
+{
+    // Hashing the source happens here, on the pool, so only crowd users pay for it
+    const QByteArray key = m_restSource.isEmpty() ? QByteArray() : AssetCache::keyFor(m_restSource);
+    if (!key.isEmpty() && AssetCache::load(key, m_evaluator.source(), blas))
+        return;
+
+    // Over the constructed spheres, which are what a cache entry is checked against
+    SphereSoA rest;
+    rest.assign(m_evaluator.source().sphere);
+    blas.build(rest);
+    if (!key.isEmpty())
+        AssetCache::store(key, m_evaluator.source(), blas);
+}
+
+void CrowdRenderer::installBuilt()
+{
+    for (BuiltPose &built : m_built)
+    {
+        // The instances may have changed while the batch ran
+        const auto it = m_groups.find(built.key);
+        if (it == m_groups.end() || it->second.mesh)
+            continue;
+
+        built.mesh->upload();
+        it->second.mesh = std::move(built.mesh);
+        it->second.blas = std::move(built.blas);
+    }
+
+    m_built.clear();
+    m_layoutDirty = true;
+}
+
+void CrowdRenderer::invalidateLayout()
+{
+    // The TLAS points into the groups and props just replaced: drop it until update() rebuilds it
+    m_tlas.build({});
+    m_tlasTargets.clear();
+    m_layoutDirty = true;
+}
+
+void CrowdRenderer::rebuildLayout()
+{
+    m_transforms.clear();
+    m_tlasTargets.clear();
+
+    std::vector<InstanceBVH::Instance> tlas;
+    for (auto &[key, group] : m_groups)
+    {
+        if (!group.mesh)
+            continue;
+
+        group.firstTransform = m_transforms.size();
+        for (const uint32_t i : group.instances)
+        {
+            m_transforms.push_back(m_instances[i].transform);
+            tlas.push_back({ m_instances[i].transform, &group.blas });
+            m_tlasTargets.push_back({ i, false });
+        }
+    }
+
+    for (uint32_t p = 0; p < m_props.size(); p++)
+    {
+        tlas.push_back({ m_props[p]->transform, nullptr, &m_props[p]->blas });
+        m_tlasTargets.push_back({ p, true });
+    }
+
+    m_tlas.build(tlas);
+
+    if (!m_transformBuffer.isCreated())
+        m_transformBuffer.create();
+    m_transformBuffer.bind();
+    m_transformBufferBytes = m_transforms.size() * sizeof(glm::mat4);
+    m_transformBuffer.allocate(m_transforms.data(), static_cast<int>(m_transformBufferBytes));
+    m_transformBuffer.release();
+
+    m_layoutDirty = false;
+}
+
+void CrowdRenderer::resolveInstancing()
+{
+    if (m_instancingResolved)
+        return;
+    m_instancingResolved = true;
+
+    // The widget runs a legacy 2.1 context, which only exposes instancing through extensions
+    const QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (context->hasExtension("GL_ARB_instanced_arrays") && context->hasExtension("GL_ARB_draw_instanced"))
+    {
+        m_vertexAttribDivisor = reinterpret_cast<VertexAttribDivisor>(
+            context->getProcAddress("glVertexAttribDivisorARB"));
+        m_drawElementsInstanced = reinterpret_cast<DrawElementsInstanced>(
+            context->getProcAddress("glDrawElementsInstancedARB"));
+    }
+
+    if (!isInstanced())
+        qDebug() << "Instanced arrays unavailable, the crowd is drawn one instance at a time";
+}
+
+void CrowdRenderer::render(const Shader *shader, const Shader *instancedShader)
+{
+    resolveInstancing();
+
+    const bool instanced = isInstanced() && instancedShader &&
+                           instancedShader->program()->attributeLocation("aModel") >= 0;
+    const Shader *program = instanced ? instancedShader : shader;
+
+    program->use();
+    for (const auto &[key, group] : m_groups)
+        if (group.mesh)
+            drawGroup(group, program, instanced);
+    program->release();
+}
+
+void CrowdRenderer::drawGroup(const PoseGroup &group, const Shader *shader, const bool instanced)
+{
+    BumperMesh &mesh = *group.mesh;
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+
+    mesh.vao.bind();
+
+    // A mat4 attribute takes four consecutive locations, one column each
+    const GLuint model = instanced ? static_cast<GLuint>(shader->program()->attributeLocation("aModel")) : 0;
+    if (instanced)
+    {
+        m_transformBuffer.bind();
+        const size_t base = group.firstTransform * sizeof(glm::mat4);
+        for (GLuint column = 0; column < 4; column++)
+        {
+            f->glVertexAttribPointer(model + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                     reinterpret_cast<void*>(base + column * sizeof(glm::vec4)));
+            f->glEnableVertexAttribArray(model + column);
+            m_vertexAttribDivisor(model + column, 1);
+        }
+        m_transformBuffer.release();
+    }
+
+    mesh.vbo.bind();
+
+    for (const auto &sub : mesh.subMeshes)
+    {
+        shader->setVec3("material.ambient",  sub.color);
+        shader->setVec3("material.diffuse",  sub.color);
+        shader->setVec3("material.specular", glm::vec3(0.1f, 0.1f, 0.1f));
+        shader->setFloat("material.shininess", 32.0f);
+
+        mesh.bindVertexAttributes(sub.baseVertex);
+
+        const auto indexCount = static_cast<GLsizei>(sub.indexCount);
+        if (instanced)
+        {
+            m_drawElementsInstanced(GL_TRIANGLES, indexCount, mesh.indexType(sub), mesh.indexOffset(sub),
+                                    static_cast<GLsizei>(group.instances.size()));
+            continue;
+        }
+
+        for (const uint32_t i : group.instances)
+        {
+            shader->setMat4("model", m_instances[i].transform);
+            f->glDrawElements(GL_TRIANGLES, indexCount, mesh.indexType(sub), mesh.indexOffset(sub));
+        }
+    }
+
+    // The mesh VAO is shared with the single character view
+    if (instanced)
+    {
+        for (GLuint column = 0; column < 4; column++)
+        {
+            m_vertexAttribDivisor(model + column, 0);
+            f->glDisableVertexAttribArray(model + column);
+        }
+    }
+
+    mesh.vbo.release();
+    mesh.vao.release();
+}
+
+bool CrowdRenderer::intersect(const Ray &ray, RayHit &hit) const
+{
+    if (!m_tlas.intersect(ray, hit))
+        return false;
+
+    const TlasTarget &target = m_tlasTargets[hit.instance];
+    hit.instance = target.prop ? RayHit::NONE : target.index;
+    hit.prop = target.prop ? target.index : RayHit::NONE;
+    return true;
+}
+
+void CrowdRenderer::reportMemory(MemoryReport &report) const
+{
+    size_t meshCpuBytes = 0, meshGpuBytes = 0;
+    size_t bvhBytes = m_tlas.bytes();
+    for (const auto &[key, group] : m_groups)
+    {
+        bvhBytes += group.blas.bytes();
+        if (group.mesh)
+        {
+            meshCpuBytes += group.mesh->cpuBytes();
+            meshGpuBytes += group.mesh->gpuBytes();
+        }
+    }
+
+    report.add("crowd meshes", meshCpuBytes, meshGpuBytes);
+    report.add("crowd BVH", bvhBytes, 0);
+    report.add("crowd transforms", m_transforms.capacity() * sizeof(glm::mat4), m_transformBufferBytes);
+}
+
+std::vector<CrowdInstance> CrowdRenderer::grid(const size_t count, const float spacing, const Pose &min,
+                                               const Pose &max, const size_t poseVariants)
+{
+    std::vector<CrowdInstance> crowd(count);
+    if (count == 0)
+        return crowd;
+
+    const auto columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+    const size_t rows = (count + columns - 1) / columns;
+    const size_t variants = std::max<size_t>(1, poseVariants);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const glm::vec3 position(
+            (static_cast<float>(i % columns) - static_cast<float>(columns - 1) * 0.5f) * spacing,
+            0.0f,
+            (static_cast<float>(i / columns) - static_cast<float>(rows - 1) * 0.5f) * spacing);
+        const float heading = glm::radians(static_cast<float>((i * 37) % 360));
+
+        crowd[i].transform = glm::rotate(glm::translate(glm::mat4(1.0f), position), heading,
+                                         glm::vec3(0.0f, 1.0f, 0.0f));
+
+        // Spread the variants over both pose axes
+        const size_t v = i % variants;
+        const float last = static_cast<float>(std::max<size_t>(1, variants - 1));
+        crowd[i].pose = {
+            glm::mix(min.alpha, max.alpha, static_cast<float>(v) / last),
+            glm::mix(min.beta, max.beta, static_cast<float>((v * 5) % variants) / last)
+        };
+    }
+
+    return crowd;
+}
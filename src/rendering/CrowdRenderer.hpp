@@ -0,0 +1,163 @@
+#pragma once
+
+#include "bumper_graph.h"
+#include "BumperMesh.hpp"
+#include "GeometryCache.hpp"
+#include "MemoryReport.hpp"
+#include "Prop.hpp"
+#include "Shader.hpp"
+#include "../animation/Pose.hpp"
+#include "../animation/PoseBatchEvaluator.hpp"
+#include "../core/ThreadPool.hpp"
+#include "../geometry/BumperGeometryBuilder.hpp"
+#include "../geometry/InstanceBVH.hpp"
+#include "../geometry/SphereBVH.hpp"
+
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QString>
+
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+struct CrowdInstance
+{
+	glm::mat4 transform { 1.0f };
+	Pose pose;
+};
+
+/**
+ * @brief Draws many transformed and posed copies of one sphere mesh.
+ *
+ * Instances are grouped by their pose snapped to the quantum. Each distinct
+ * pose is evaluated once from the rest graph and drawn for the whole group
+ * with one instanced call per submesh when the context has
+ * GL_ARB_instanced_arrays, or one call per instance otherwise. Per-pose sphere
+ * BVHs under an instance BVH form a two level acceleration structure for ray
+ * queries against the crowd.
+ *
+ * Pose evaluation, BVH builds and tessellation run as one batch at a time on
+ * the thread pool; update() only uploads finished meshes, so the GUI thread
+ * never waits on them. The meshes stay with their groups rather than in the
+ * GeometryCache: they are posed absolutely from the rest graph, whereas the
+ * single-character view poses the live graph incrementally, so the two must
+ * not serve each other's meshes.
+ *
+ * Props placed by the renderer join the instance BVH, so one traversal
+ * covers both the characters and the set around them.
+ *
+ * Only bumpers are drawn, the sphere impostors stay a single-character view.
+ */
+class CrowdRenderer
+{
+public:
+	CrowdRenderer(const SM::Graph::BumperGraph &rest, BumperBuckets buckets, float quantum,
+				  ThreadPool &pool = ThreadPool::global());
+	~CrowdRenderer();
+
+	CrowdRenderer(const CrowdRenderer &) = delete;
+	CrowdRenderer &operator=(const CrowdRenderer &) = delete;
+
+	// Everything but the queries releases or creates GL objects: keep the
+	// renderer context current, including when destroying the crowd
+	void setInstances(std::vector<CrowdInstance> instances);
+	const std::vector<CrowdInstance> &instances() const;
+
+	// Poses built per background batch; instances of the others appear once theirs is ready
+	void setMaxPosesPerUpdate(size_t count);
+
+	// Source of the rest graph: the rest pose group then takes its BVH from the AssetCache,
+	// or builds and stores it there on the first batch that needs it
+	void setRestSource(const QString &path);
+
+	// Traced with the crowd but drawn by their owner, who keeps them alive
+	void setProps(std::vector<const Prop*> props);
+
+	void update();
+	void render(const Shader *shader, const Shader *instancedShader);
+
+	// Characters set hit.instance, props set hit.prop; the other is left at RayHit::NONE.
+	// Misses everything between setInstances() or setProps() and the next update()
+	bool intersect(const Ray &ray, RayHit &hit) const;
+
+	size_t poseCount() const;
+	bool isReady() const;
+	bool isInstanced() const;
+
+	void reportMemory(MemoryReport &report) const;
+
+	static std::vector<CrowdInstance> grid(size_t count, float spacing, const Pose &min, const Pose &max,
+										   size_t poseVariants);
+
+private:
+	struct PoseGroup
+	{
+		std::shared_ptr<BumperMesh> mesh;
+		SphereBVH blas;
+		std::vector<uint32_t> instances;
+		size_t firstTransform = 0;
+	};
+
+	// Filled by a background batch, uploaded and handed to its group on the GUI thread
+	struct BuiltPose
+	{
+		PoseKey key;
+		std::shared_ptr<BumperMesh> mesh;
+		SphereBVH blas;
+	};
+
+	using VertexAttribDivisor = void (QOPENGLF_APIENTRYP)(GLuint index, GLuint divisor);
+	using DrawElementsInstanced = void (QOPENGLF_APIENTRYP)(GLenum mode, GLsizei count, GLenum type,
+															 const void *indices, GLsizei instances);
+
+	PoseBatchEvaluator m_evaluator;
+	BumperGeometryBuilder m_builder;
+	ThreadPool &m_pool;
+	float m_quantum;
+
+	std::vector<CrowdInstance> m_instances;
+	std::vector<const Prop*> m_props;
+	std::unordered_map<PoseKey, PoseGroup, PoseKeyHash> m_groups;
+	std::vector<PoseKey> m_pending;
+	size_t m_maxPosesPerUpdate = 8;
+	QString m_restSource;
+
+	// Transforms of the ready groups, one contiguous run per group
+	std::vector<glm::mat4> m_transforms;
+	QOpenGLBuffer m_transformBuffer { QOpenGLBuffer::VertexBuffer };
+	size_t m_transformBufferBytes = 0;
+
+	// What each TLAS instance stands for, so character and prop indices never mix
+	struct TlasTarget
+	{
+		uint32_t index;
+		bool prop;
+	};
+
+	InstanceBVH m_tlas;
+	std::vector<TlasTarget> m_tlasTargets;
+	bool m_layoutDirty = false;
+
+	bool m_instancingResolved = false;
+	VertexAttribDivisor m_vertexAttribDivisor = nullptr;
+	DrawElementsInstanced m_drawElementsInstanced = nullptr;
+
+	// Only the running batch touches these until m_buildTask is ready
+	std::future<void> m_buildTask;
+	std::vector<BuiltPose> m_built;
+	std::vector<SphereSoA> m_posed;
+	std::vector<SM::Sphere> m_spheres;
+
+	PoseKey keyFor(const Pose &pose) const;
+	bool isBuilding(const PoseKey &key) const;
+	void buildPending();
+	void buildBatch();
+	void buildRestBlas(SphereBVH &blas) const;
+	void installBuilt();
+	void invalidateLayout();
+	void rebuildLayout();
+	void resolveInstancing();
+	void drawGroup(const PoseGroup &group, const Shader *shader, bool instanced);
+};
@@ -0,0 +1,267 @@
+#include "FrameProfiler.hpp"
+
+#include <QDebug>
+#include <QStringList>
+
+#include <algorithm>
+
+FrameProfiler::Scope::Scope(FrameProfiler *profiler, const Stage stage)
+    : m_profiler(profiler && profiler->isEnabled() ? profiler : nullptr)
+    , m_stage(stage)
+{
+    if (!m_profiler)
+        return;
+
+    m_clock.start();
+    m_gpu = isGpuStage(stage) && m_profiler->beginGpuStage(stage);
+}
+
+FrameProfiler::Scope::~Scope()
+{
+    if (!m_profiler)
+        return;
+
+    if (m_gpu)
+        m_profiler->endGpuStage(m_stage);
+    m_profiler->addCpuTime(m_stage, static_cast<double>(m_clock.nsecsElapsed()) * 1e-6);
+}
+
+FrameProfiler::FrameProfiler() = default;
+
+FrameProfiler::~FrameProfiler() = default;
+
+const char *FrameProfiler::stageName(const Stage stage)
+{
+    switch (stage)
+    {
+        case POSE: return "pose";
+        case BUILD: return "build";
+        case UPLOAD: return "upload";
+        case SPHERES: return "spheres";
+        case BUMPERS: return "bumpers";
+        case FRAME: return "frame";
+        default: return "?";
+    }
+}
+
+bool FrameProfiler::isGpuStage(const Stage stage)
+{
+    return stage == UPLOAD || stage == SPHERES || stage == BUMPERS;
+}
+
+void FrameProfiler::setEnabled(const bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool FrameProfiler::isEnabled() const
+{
+    return m_enabled || m_csv.isOpen();
+}
+
+bool FrameProfiler::setCsvLog(const QString &path)
+{
+    m_csv.close();
+    m_csv.setFileName(path);
+    if (!m_csv.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot open frame timing log:" << path;
+        return false;
+    }
+
+    QStringList header { "frame" };
+    for (int s = 0; s < STAGE_COUNT; s++)
+        header << QString("%1_cpu_ms").arg(stageName(static_cast<Stage>(s)));
+    for (int s = 0; s < STAGE_COUNT; s++)
+        if (isGpuStage(static_cast<Stage>(s)))
+            header << QString("%1_gpu_ms").arg(stageName(static_cast<Stage>(s)));
+    m_csv.write((header.join(',') + '\n').toUtf8());
+    return true;
+}
+
+void FrameProfiler::createMonitors()
+{
+    m_gpuChecked = true;
+
+    for (auto &slot : m_slots)
+    {
+        slot.monitor = std::make_unique<QOpenGLTimeMonitor>();
+        slot.monitor->setSampleCount(2 * GPU_STAGE_COUNT);
+        if (!slot.monitor->create())
+        {
+            qDebug() << "GL timer queries unavailable, frame timings are CPU only";
+            destroy();
+            m_gpuChecked = true;
+            return;
+        }
+    }
+
+    m_gpuAvailable = true;
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (!isEnabled())
+        return;
+
+    m_inFrame = true;
+    m_current = {};
+    m_frameClock.start();
+
+    if (!m_gpuChecked)
+        createMonitors();
+    if (!m_gpuAvailable)
+        return;
+
+    collect();
+
+    // With every monitor still in flight this frame goes without GPU times rather than stalling
+    Slot &slot = m_slots[m_next];
+    m_recording = slot.pending ? nullptr : &slot;
+}
+
+void FrameProfiler::endFrame()
+{
+    if (!m_inFrame)
+        return;
+    m_inFrame = false;
+
+    m_current[FRAME] = static_cast<double>(m_frameClock.nsecsElapsed()) * 1e-6;
+    accumulate(m_cpuAverage, m_current, m_hasCpuAverage);
+
+    if (m_recording)
+    {
+        Slot &slot = *m_recording;
+        while (slot.samples < static_cast<int>(2 * GPU_STAGE_COUNT))
+        {
+            slot.monitor->recordSample();
+            slot.samples++;
+        }
+        slot.cpu = m_current;
+        slot.frame = m_frame;
+        slot.pending = true;
+
+        m_recording = nullptr;
+        m_next = (m_next + 1) % RING_DEPTH;
+    }
+    else
+    {
+        writeRow(m_frame, m_current, nullptr);
+    }
+
+    m_frame++;
+}
+
+void FrameProfiler::addCpuTime(const Stage stage, const double ms)
+{
+    if (isEnabled())
+        m_current[stage] += ms;
+}
+
+bool FrameProfiler::beginGpuStage(const Stage stage)
+{
+    if (!m_recording)
+        return false;
+
+    Slot &slot = *m_recording;
+    const auto end = slot.stages.begin() + static_cast<std::ptrdiff_t>(slot.stageCount);
+    if (slot.stageCount == GPU_STAGE_COUNT || std::find(slot.stages.begin(), end, stage) != end)
+        return false;
+
+    slot.stages[slot.stageCount++] = stage;
+    slot.monitor->recordSample();
+    slot.samples++;
+    return true;
+}
+
+void FrameProfiler::endGpuStage(const Stage)
+{
+    if (!m_recording)
+        return;
+
+    m_recording->monitor->recordSample();
+    m_recording->samples++;
+}
+
+void FrameProfiler::collect()
+{
+    // Oldest first, stopping at the first frame the GPU has not finished
+    for (size_t i = 0; i < RING_DEPTH; i++)
+    {
+        Slot &slot = m_slots[(m_next + i) % RING_DEPTH];
+        if (!slot.pending)
+            continue;
+        if (!slot.monitor->isResultAvailable())
+            break;
+
+        // Interval 2k spans the samples bracketing the k-th stage
+        const auto intervals = slot.monitor->waitForIntervals();
+        Times gpu {};
+        for (size_t k = 0; k < slot.stageCount && 2 * k < static_cast<size_t>(intervals.size()); k++)
+            gpu[slot.stages[k]] += static_cast<double>(intervals[static_cast<int>(2 * k)]) * 1e-6;
+
+        accumulate(m_gpuAverage, gpu, m_hasGpuAverage);
+        writeRow(slot.frame, slot.cpu, &gpu);
+
+        slot.monitor->reset();
+        slot.samples = 0;
+        slot.stageCount = 0;
+        slot.pending = false;
+    }
+}
+
+void FrameProfiler::destroy()
+{
+    for (auto &slot : m_slots)
+    {
+        if (slot.monitor)
+            slot.monitor->destroy();
+        slot = Slot {};
+    }
+
+    m_next = 0;
+    m_recording = nullptr;
+    m_gpuChecked = false;
+    m_gpuAvailable = false;
+}
+
+void FrameProfiler::writeRow(const uint64_t frame, const Times &cpu, const Times *gpu)
+{
+    if (!m_csv.isOpen())
+        return;
+
+    QStringList fields { QString::number(static_cast<qulonglong>(frame)) };
+    for (int s = 0; s < STAGE_COUNT; s++)
+        fields << QString::number(cpu[s], 'f', 3);
+    for (int s = 0; s < STAGE_COUNT; s++)
+        if (isGpuStage(static_cast<Stage>(s)))
+            fields << (gpu ? QString::number((*gpu)[s], 'f', 3) : QString());
+    m_csv.write((fields.join(',') + '\n').toUtf8());
+}
+
+void FrameProfiler::accumulate(Times &average, const Times &sample, bool &initialized)
+{
+    for (size_t s = 0; s < average.size(); s++)
+        average[s] = initialized ? average[s] + AVERAGE_WEIGHT * (sample[s] - average[s]) : sample[s];
+    initialized = true;
+}
+
+uint64_t FrameProfiler::frameCount() const
+{
+    return m_frame;
+}
+
+QString FrameProfiler::summary() const
+{
+    // Pose and build run on the geometry worker, so they are not part of the frame time
+    QStringList lines;
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        const auto stage = static_cast<Stage>(s);
+        QString line = QString("%1 cpu %2 ms").arg(stageName(stage), -8).arg(m_cpuAverage[s], 6, 'f', 2);
+        if (isGpuStage(stage) && m_hasGpuAverage)
+            line += QString("  gpu %1 ms").arg(m_gpuAverage[s], 6, 'f', 2);
+        lines << line;
+    }
+    return lines.join('\n');
+}
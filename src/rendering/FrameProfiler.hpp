@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QOpenGLTimeMonitor>
+#include <QString>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Per-stage CPU and GPU timings of the rendered frames.
+ *
+ * Stages are timed with Scope objects; times measured elsewhere, like the
+ * pose and build on the geometry worker, are added with addCpuTime(). GPU
+ * stages are bracketed by timer queries through a small ring of
+ * QOpenGLTimeMonitor, whose results are read frames later once available, so
+ * profiling never waits on the GPU. Without timer query support only CPU
+ * times are reported.
+ *
+ * Timings are averaged for summary() and, when a CSV log is set, written one
+ * row per frame. Rows of frames with GPU times are written once those arrive,
+ * so they can come a few frames out of order; the first column is the frame
+ * number. Everything but addCpuTime() and Scope on CPU-only stages expects the
+ * GL context to be current.
+ */
+class FrameProfiler
+{
+public:
+	enum Stage
+	{
+		POSE,
+		BUILD,
+		UPLOAD,
+		SPHERES,
+		BUMPERS,
+		FRAME,
+		STAGE_COUNT
+	};
+
+	class Scope
+	{
+	public:
+		// A null or disabled profiler makes the scope a no-op
+		Scope(FrameProfiler *profiler, Stage stage);
+		~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		FrameProfiler *m_profiler;
+		Stage m_stage;
+		QElapsedTimer m_clock;
+		bool m_gpu = false;
+	};
+
+	FrameProfiler();
+	~FrameProfiler();
+
+	FrameProfiler(const FrameProfiler &) = delete;
+	FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+	static const char *stageName(Stage stage);
+	static bool isGpuStage(Stage stage);
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	bool setCsvLog(const QString &path);
+
+	void beginFrame();
+	void endFrame();
+	void addCpuTime(Stage stage, double ms);
+	void destroy();
+
+	uint64_t frameCount() const;
+	QString summary() const;
+
+private:
+	static constexpr size_t RING_DEPTH = 3;
+	static constexpr size_t GPU_STAGE_COUNT = 3;
+	static constexpr double AVERAGE_WEIGHT = 0.05;
+
+	using Times = std::array<double, STAGE_COUNT>;
+
+	// Each GPU stage is bracketed by two samples, unused pairs are padded at the end of the frame
+	struct Slot
+	{
+		std::unique_ptr<QOpenGLTimeMonitor> monitor;
+		std::array<Stage, GPU_STAGE_COUNT> stages {};
+		size_t stageCount = 0;
+		int samples = 0;
+		Times cpu {};
+		uint64_t frame = 0;
+		bool pending = false;
+	};
+
+	bool m_enabled = false;
+	bool m_inFrame = false;
+	uint64_t m_frame = 0;
+	QElapsedTimer m_frameClock;
+	Times m_current {};
+
+	std::array<Slot, RING_DEPTH> m_slots;
+	size_t m_next = 0;
+	Slot *m_recording = nullptr;
+	bool m_gpuChecked = false;
+	bool m_gpuAvailable = false;
+
+	Times m_cpuAverage {};
+	Times m_gpuAverage {};
+	bool m_hasCpuAverage = false;
+	bool m_hasGpuAverage = false;
+
+	QFile m_csv;
+
+	void createMonitors();
+	void collect();
+	bool beginGpuStage(Stage stage);
+	void endGpuStage(Stage stage);
+	void writeRow(uint64_t frame, const Times &cpu, const Times *gpu);
+	static void accumulate(Times &average, const Times &sample, bool &initialized);
+};
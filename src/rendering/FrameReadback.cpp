@@ -0,0 +1,166 @@
+#include "FrameReadback.hpp"
+
+#include <QDebug>
+#include <QOpenGLFunctions>
+
+#include <algorithm>
+#include <cstring>
+
+FrameReadback::FrameReadback(const size_t depth)
+    : m_slots(std::max<size_t>(2, depth))
+{
+}
+
+void FrameReadback::resolve()
+{
+    if (m_resolved)
+        return;
+    m_resolved = true;
+
+    // The legacy 2.1 context only has fences through GL_ARB_sync, which shares the core names
+    const QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (context->hasExtension("GL_ARB_sync"))
+    {
+        m_fenceSync = reinterpret_cast<FenceSync>(context->getProcAddress("glFenceSync"));
+        m_clientWaitSync = reinterpret_cast<ClientWaitSync>(context->getProcAddress("glClientWaitSync"));
+        m_deleteSync = reinterpret_cast<DeleteSync>(context->getProcAddress("glDeleteSync"));
+    }
+
+    if (!usesFences())
+        qDebug() << "GL_ARB_sync unavailable, frames are read back" << m_slots.size() - 1 << "captures late";
+}
+
+bool FrameReadback::usesFences() const
+{
+    return m_fenceSync && m_clientWaitSync && m_deleteSync;
+}
+
+void FrameReadback::capture(const int width, const int height, const FrameCallback &ready)
+{
+    resolve();
+    collect(ready);
+
+    // The whole ring is in flight: the oldest frame has to be waited for
+    Slot &slot = m_slots[m_next];
+    if (slot.pending)
+    {
+        m_stalls++;
+        retrieve(slot, ready);
+    }
+
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+
+    if (!slot.buffer.isCreated())
+    {
+        slot.buffer.create();
+        slot.buffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+    }
+    slot.buffer.bind();
+
+    const size_t bytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+    if (slot.bytes != bytes)
+    {
+        slot.buffer.allocate(static_cast<int>(bytes));
+        slot.bytes = bytes;
+    }
+
+    // With a pack buffer bound the pointer is an offset and the copy runs asynchronously
+    f->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    slot.buffer.release();
+
+    slot.fence = usesFences() ? m_fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : nullptr;
+    slot.width = width;
+    slot.height = height;
+    slot.frame = m_frame++;
+    slot.pending = true;
+
+    m_next = (m_next + 1) % m_slots.size();
+}
+
+bool FrameReadback::isReady(const Slot &slot) const
+{
+    if (slot.fence)
+    {
+        const GLenum status = m_clientWaitSync(slot.fence, 0, 0);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    }
+
+    return slot.frame + m_slots.size() - 1 <= m_frame;
+}
+
+void FrameReadback::collect(const FrameCallback &ready)
+{
+    // Oldest first, stopping at the first unfinished frame to keep the order
+    for (size_t i = 0; i < m_slots.size(); i++)
+    {
+        Slot &slot = m_slots[(m_next + i) % m_slots.size()];
+        if (!slot.pending)
+            continue;
+        if (!isReady(slot))
+            break;
+        retrieve(slot, ready);
+    }
+}
+
+void FrameReadback::flush(const FrameCallback &ready)
+{
+    for (size_t i = 0; i < m_slots.size(); i++)
+    {
+        Slot &slot = m_slots[(m_next + i) % m_slots.size()];
+        if (slot.pending)
+            retrieve(slot, ready);
+    }
+}
+
+void FrameReadback::retrieve(Slot &slot, const FrameCallback &ready)
+{
+    if (slot.fence)
+    {
+        constexpr GLuint64 TIMEOUT_NS = 1000000000ull;
+        if (m_clientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT_NS) == GL_WAIT_FAILED)
+            qDebug() << "Waiting for a frame readback failed";
+        m_deleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    slot.pending = false;
+
+    slot.buffer.bind();
+    const auto *pixels = static_cast<const uchar*>(slot.buffer.map(QOpenGLBuffer::ReadOnly));
+    if (!pixels)
+    {
+        qDebug() << "Cannot map frame readback buffer";
+        slot.buffer.release();
+        return;
+    }
+
+    QImage frame(slot.width, slot.height, QImage::Format_RGBA8888);
+    std::memcpy(frame.bits(), pixels, slot.bytes);
+    slot.buffer.unmap();
+    slot.buffer.release();
+
+    if (ready)
+        ready(std::move(frame));
+}
+
+void FrameReadback::destroy()
+{
+    for (auto &slot : m_slots)
+    {
+        if (slot.fence)
+            m_deleteSync(slot.fence);
+        slot.buffer.destroy();
+        slot = Slot {};
+    }
+    m_next = 0;
+}
+
+size_t FrameReadback::pending() const
+{
+    return static_cast<size_t>(std::count_if(m_slots.begin(), m_slots.end(),
+                                             [](const Slot &slot) { return slot.pending; }));
+}
+
+size_t FrameReadback::stalls() const
+{
+    return m_stalls;
+}
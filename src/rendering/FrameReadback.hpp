@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QImage>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Reads rendered frames back through a ring of pixel buffer objects.
+ *
+ * capture() only queues the copy of the bound framebuffer into the next
+ * buffer of the ring, then returns. Later calls hand finished frames, oldest
+ * first, to a callback, so frame K is mapped while K+1 and K+2 are still
+ * rendering. A buffer is finished when its fence has signaled
+ * (GL_ARB_sync), or, without fences, once it is depth - 1 captures old.
+ * Only when the whole ring is still in flight does capture() wait.
+ *
+ * Frames are RGBA8888, bottom row first. Everything must run with the context
+ * that renders the frames current, including destroy().
+ */
+class FrameReadback
+{
+public:
+	using FrameCallback = std::function<void(QImage frame)>;
+
+	static constexpr size_t DEFAULT_DEPTH = 3;
+
+	explicit FrameReadback(size_t depth = DEFAULT_DEPTH);
+
+	void capture(int width, int height, const FrameCallback &ready);
+	void collect(const FrameCallback &ready);
+	void flush(const FrameCallback &ready);
+	void destroy();
+
+	bool usesFences() const;
+	size_t pending() const;
+	size_t stalls() const;
+
+private:
+	using FenceSync = GLsync (QOPENGLF_APIENTRYP)(GLenum condition, GLbitfield flags);
+	using ClientWaitSync = GLenum (QOPENGLF_APIENTRYP)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+	using DeleteSync = void (QOPENGLF_APIENTRYP)(GLsync sync);
+
+	struct Slot
+	{
+		QOpenGLBuffer buffer { QOpenGLBuffer::PixelPackBuffer };
+		size_t bytes = 0;
+		GLsync fence = nullptr;
+		int width = 0;
+		int height = 0;
+		uint64_t frame = 0;
+		bool pending = false;
+	};
+
+	std::vector<Slot> m_slots;
+	size_t m_next = 0;
+	uint64_t m_frame = 0;
+	size_t m_stalls = 0;
+
+	bool m_resolved = false;
+	FenceSync m_fenceSync = nullptr;
+	ClientWaitSync m_clientWaitSync = nullptr;
+	DeleteSync m_deleteSync = nullptr;
+
+	void resolve();
+	bool isReady(const Slot &slot) const;
+	void retrieve(Slot &slot, const FrameCallback &ready);
+};
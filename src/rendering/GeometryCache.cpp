@@ -0,0 +1,159 @@
+#include "GeometryCache.hpp"
+
+#include <cmath>
+
+GeometryCache::GeometryCache(const size_t memoryBudget, const float quantum)
+    : m_memoryBudget(memoryBudget)
+    , m_quantum(quantum)
+{
+}
+
+void GeometryCache::setMemoryBudget(const size_t bytes)
+{
+    std::lock_guard lock(m_mutex);
+    m_memoryBudget = bytes;
+    evictToBudget();
+}
+
+size_t GeometryCache::memoryBudget() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_memoryBudget;
+}
+
+void GeometryCache::setQuantum(const float quantum)
+{
+    std::lock_guard lock(m_mutex);
+    if (quantum <= 0.0f || quantum == m_quantum)
+        return;
+
+    // Keys built with the old step no longer describe the same poses
+    m_quantum = quantum;
+    clearLocked();
+}
+
+float GeometryCache::quantum() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_quantum;
+}
+
+void GeometryCache::setEnabled(const bool enabled)
+{
+    std::lock_guard lock(m_mutex);
+    m_enabled = enabled;
+    if (!m_enabled)
+        clearLocked();
+}
+
+std::optional<PoseKey> GeometryCache::keyFor(const float alpha, const float beta) const
+{
+    std::lock_guard lock(m_mutex);
+    const float a = alpha / m_quantum;
+    const float b = beta / m_quantum;
+    const float snappedA = std::round(a);
+    const float snappedB = std::round(b);
+    if (std::fabs(a - snappedA) > GRID_TOLERANCE || std::fabs(b - snappedB) > GRID_TOLERANCE)
+        return std::nullopt;
+
+    return PoseKey { static_cast<int>(snappedA), static_cast<int>(snappedB) };
+}
+
+bool GeometryCache::contains(const PoseKey &key) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_enabled && m_index.find(key) != m_index.end();
+}
+
+std::shared_ptr<BumperMesh> GeometryCache::find(const PoseKey &key)
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_enabled)
+        return nullptr;
+
+    const auto it = m_index.find(key);
+    if (it == m_index.end())
+    {
+        m_stats.misses++;
+        return nullptr;
+    }
+
+    m_stats.hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->mesh;
+}
+
+void GeometryCache::insert(const PoseKey &key, const std::shared_ptr<BumperMesh> &mesh)
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_enabled || !mesh)
+        return;
+
+    const Entry entry { key, mesh, mesh->cpuBytes(), mesh->gpuBytes() };
+    if (entry.cpuBytes + entry.gpuBytes > m_memoryBudget)
+        return;
+
+    if (const auto it = m_index.find(key); it != m_index.end())
+    {
+        account(*it->second, -1);
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_lru.push_front(entry);
+    m_index[key] = m_lru.begin();
+    account(entry, 1);
+    m_stats.entries = m_lru.size();
+
+    evictToBudget();
+}
+
+void GeometryCache::clear()
+{
+    std::lock_guard lock(m_mutex);
+    clearLocked();
+}
+
+void GeometryCache::clearLocked()
+{
+    m_lru.clear();
+    m_index.clear();
+    m_stats.bytes = 0;
+    m_stats.cpuBytes = 0;
+    m_stats.gpuBytes = 0;
+    m_stats.entries = 0;
+}
+
+GeometryCache::Stats GeometryCache::stats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+void GeometryCache::evictToBudget()
+{
+    while (m_stats.bytes > m_memoryBudget && !m_lru.empty())
+    {
+        const Entry &victim = m_lru.back();
+        account(victim, -1);
+        m_index.erase(victim.key);
+        m_lru.pop_back();
+        m_stats.evictions++;
+    }
+    m_stats.entries = m_lru.size();
+}
+
+void GeometryCache::account(const Entry &entry, const int sign)
+{
+    if (sign > 0)
+    {
+        m_stats.cpuBytes += entry.cpuBytes;
+        m_stats.gpuBytes += entry.gpuBytes;
+    }
+    else
+    {
+        m_stats.cpuBytes -= entry.cpuBytes;
+        m_stats.gpuBytes -= entry.gpuBytes;
+    }
+    m_stats.bytes = m_stats.cpuBytes + m_stats.gpuBytes;
+}
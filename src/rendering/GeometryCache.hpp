@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "BumperMesh.hpp"
+
+/**
+ * @brief Pose coordinates snapped to the cache quantum.
+ */
+struct PoseKey
+{
+	int alpha = 0;
+	int beta = 0;
+
+	bool operator==(const PoseKey &other) const
+	{
+		return alpha == other.alpha && beta == other.beta;
+	}
+};
+
+struct PoseKeyHash
+{
+	size_t operator()(const PoseKey &key) const
+	{
+		return std::hash<long long>()((static_cast<long long>(key.alpha) << 32) ^
+		                              static_cast<unsigned int>(key.beta));
+	}
+};
+
+/**
+ * @brief Memory bounded LRU cache from a quantized (alpha, beta) pose to the
+ *        bumper geometry built for it.
+ *
+ * Only poses on the quantization grid have a key: a mesh served for a pose
+ * between grid points would not match the spheres drawn with it, so those
+ * poses always get their own geometry.
+ *
+ * Entries own both the CPU arrays and the GPU buffers of a mesh, so evicting
+ * an entry releases GL objects: insert() and clear() must be called with the
+ * renderer context current. keyFor() and contains() may be called from the
+ * geometry worker thread.
+ */
+class GeometryCache
+{
+public:
+	struct Stats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+		size_t entries = 0;
+		size_t bytes = 0;
+		size_t cpuBytes = 0;
+		size_t gpuBytes = 0;
+	};
+
+	explicit GeometryCache(size_t memoryBudget = 256u << 20, float quantum = 0.5f);
+
+	void setMemoryBudget(size_t bytes);
+	size_t memoryBudget() const;
+
+	void setQuantum(float quantum);
+	float quantum() const;
+
+	void setEnabled(bool enabled);
+
+	// Empty unless both coordinates lie on the grid, to within GRID_TOLERANCE of a step
+	std::optional<PoseKey> keyFor(float alpha, float beta) const;
+
+	bool contains(const PoseKey &key) const;
+	std::shared_ptr<BumperMesh> find(const PoseKey &key);
+	void insert(const PoseKey &key, const std::shared_ptr<BumperMesh> &mesh);
+	void clear();
+
+	Stats stats() const;
+
+private:
+	static constexpr float GRID_TOLERANCE = 1e-4f;
+
+	struct Entry {
+		PoseKey key;
+		std::shared_ptr<BumperMesh> mesh;
+		size_t cpuBytes;
+		size_t gpuBytes;
+	};
+
+	mutable std::mutex m_mutex;
+	std::list<Entry> m_lru;
+	std::unordered_map<PoseKey, std::list<Entry>::iterator, PoseKeyHash> m_index;
+
+	size_t m_memoryBudget;
+	float m_quantum;
+	bool m_enabled = true;
+	Stats m_stats;
+
+	void clearLocked();
+	void account(const Entry &entry, int sign);
+	void evictToBudget();
+};
@@ -0,0 +1,236 @@
+#include "GeometryWorker.hpp"
+
+#include <QElapsedTimer>
+
+#include <utility>
+
+GeometryWorker::GeometryWorker(SM::Graph::BumperGraph* bumper_graph, BumperBuckets buckets,
+                               const GeometryCache* cache)
+    : bg(bumper_graph)
+    , m_cache(cache)
+    , m_builder(std::move(buckets))
+{
+}
+
+GeometryWorker::~GeometryWorker()
+{
+    stop();
+}
+
+void GeometryWorker::setFrameReadyCallback(std::function<void()> callback)
+{
+    m_onFrameReady = std::move(callback);
+}
+
+void GeometryWorker::start()
+{
+    if (m_thread.joinable())
+        return;
+
+    // Buffers published before a restart may hold another state of the graph
+    m_spheres = bg->sphere;
+    m_generation++;
+    m_firstGeneration = m_generation;
+
+    m_running = true;
+    m_thread = std::thread(&GeometryWorker::run, this);
+}
+
+void GeometryWorker::stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_one();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void GeometryWorker::requestPose(const float alpha, const float beta)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_pendingAlpha += alpha;
+        m_pendingBeta += beta;
+        m_hasRequest = true;
+    }
+    m_wake.notify_one();
+}
+
+void GeometryWorker::requestBakedFrame(std::shared_ptr<const BakedAnimation> animation, const size_t frame)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_pendingAnimation = std::move(animation);
+        m_pendingFrame = frame;
+    }
+    m_wake.notify_one();
+}
+
+bool GeometryWorker::takeFrame(Frame &frame)
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_readyValid)
+        return false;
+
+    // The caller's previous front buffer is recycled as the next ready slot
+    std::swap(frame, m_ready);
+    m_readyValid = false;
+    return true;
+}
+
+void GeometryWorker::run()
+{
+    while (true)
+    {
+        float alpha = 0.0f, beta = 0.0f;
+        std::shared_ptr<const BakedAnimation> animation;
+        size_t frame = 0;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_hasRequest || m_pendingAnimation || !m_running; });
+            if (!m_running)
+                return;
+
+            // Baked playback wins; pose deltas keep accumulating meanwhile
+            if (m_pendingAnimation)
+            {
+                animation = std::move(m_pendingAnimation);
+                frame = m_pendingFrame;
+                m_pendingAnimation.reset();
+            }
+            else
+            {
+                alpha = m_pendingAlpha;
+                beta = m_pendingBeta;
+                m_pendingAlpha = 0.0f;
+                m_pendingBeta = 0.0f;
+                m_hasRequest = false;
+            }
+        }
+
+        if (animation)
+            loadBakedFrame(*animation, frame);
+        else
+            evaluatePose(alpha, beta);
+
+        {
+            std::lock_guard lock(m_mutex);
+            std::swap(m_back, m_ready);
+            m_readyValid = true;
+        }
+
+        if (m_onFrameReady)
+            m_onFrameReady();
+    }
+}
+
+void GeometryWorker::evaluatePose(const float alpha, const float beta)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    bg->setPose(alpha, beta);
+    bg->applyPose();
+
+    m_alpha += alpha;
+    m_beta += beta;
+
+    SphereDelta::diff(m_spheres, bg->sphere, m_delta);
+    if (!m_delta.empty())
+    {
+        m_generation++;
+        std::vector<uint32_t> &changed = m_history[m_generation % HISTORY_DEPTH];
+        changed.assign(m_delta.indices.begin(), m_delta.indices.end());
+
+        // Copied rather than accumulated, so the snapshot never drifts from the graph
+        for (const uint32_t i : changed)
+            m_spheres[i] = bg->sphere[i];
+    }
+
+    m_back.key = m_cache->keyFor(m_alpha, m_beta);
+    syncSpheres(m_back);
+    m_back.hasGeometry = !m_back.key || !m_cache->contains(*m_back.key);
+    m_back.poseMs = static_cast<double>(clock.nsecsElapsed()) * 1e-6;
+
+    m_back.buildMs = 0.0;
+    if (m_back.hasGeometry)
+    {
+        clock.restart();
+        syncGeometry(m_back);
+        m_back.buildMs = static_cast<double>(clock.nsecsElapsed()) * 1e-6;
+    }
+}
+
+bool GeometryWorker::collectChangesSince(const uint64_t generation)
+{
+    m_stale.clear();
+    if (generation < m_firstGeneration || m_generation - generation > HISTORY_DEPTH)
+        return false;
+
+    // Spheres changed in several generations are listed more than once, which is harmless
+    for (uint64_t g = generation + 1; g <= m_generation; g++)
+    {
+        const std::vector<uint32_t> &changed = m_history[g % HISTORY_DEPTH];
+        m_stale.insert(m_stale.end(), changed.begin(), changed.end());
+    }
+    return true;
+}
+
+void GeometryWorker::syncSpheres(Frame &frame)
+{
+    if (frame.sphereGeneration == m_generation)
+        return;
+
+    if (frame.spheres.size() == m_spheres.size() && frame.soa.size() == m_spheres.size() &&
+        collectChangesSince(frame.sphereGeneration))
+    {
+        for (const uint32_t i : m_stale)
+        {
+            frame.spheres[i] = m_spheres[i];
+            frame.soa.set(i, m_spheres[i]);
+        }
+    }
+    else
+    {
+        frame.spheres = m_spheres;
+        frame.soa.assign(m_spheres);
+    }
+
+    frame.sphereGeneration = m_generation;
+}
+
+void GeometryWorker::syncGeometry(Frame &frame)
+{
+    if (frame.geometryGeneration == m_generation)
+        return;
+
+    // Past a quarter of the spheres a full pass is cheaper than scattered patches
+    if (!frame.geometry.vertices.empty() && collectChangesSince(frame.geometryGeneration) &&
+        m_stale.size() <= m_spheres.size() / 4)
+        m_builder.rebuild(m_spheres, m_stale, frame.geometry);
+    else
+        m_builder.build(m_spheres, frame.geometry);
+
+    frame.geometryGeneration = m_generation;
+}
+
+void GeometryWorker::loadBakedFrame(const BakedAnimation &animation, const size_t frame)
+{
+    // Baked frames may come from another rest state, so they bypass the cache
+    QElapsedTimer clock;
+    clock.start();
+
+    m_back.key.reset();
+    animation.copyFrame(frame, m_back.spheres, m_back.soa);
+    m_back.sphereGeneration = 0;
+    m_back.geometryGeneration = 0;
+    m_back.hasGeometry = true;
+    m_back.poseMs = static_cast<double>(clock.nsecsElapsed()) * 1e-6;
+
+    clock.restart();
+    m_builder.build(m_back.spheres, m_back.geometry);
+    m_back.buildMs = static_cast<double>(clock.nsecsElapsed()) * 1e-6;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "bumper_graph.h"
+#include "GeometryCache.hpp"
+#include "../animation/BakedAnimation.hpp"
+#include "../geometry/BumperGeometry.hpp"
+#include "../geometry/BumperGeometryBuilder.hpp"
+#include "../geometry/SphereDelta.hpp"
+#include "../geometry/SphereSoA.hpp"
+
+/**
+ * @brief Applies poses to the bumper graph and tessellates the result on a
+ *        background thread.
+ *
+ * Once started, the worker is the only writer of the graph. Pose deltas
+ * requested while a build is running are accumulated, so intermediate poses
+ * are never evaluated. Each finished build is published as a frame holding a
+ * snapshot of the spheres, its SoA mirror and, unless the cache already has it, the triangle
+ * geometry; a newer frame replaces one the GL thread has not picked up yet.
+ *
+ * Buffers are recycled rather than copied: every frame records the pose
+ * generation its spheres and geometry hold, and when it comes back for reuse
+ * only the spheres changed since then are copied in and only the bumpers
+ * touching them are tessellated again. Buffers more than HISTORY_DEPTH
+ * generations behind, or holding anything but a pose of the live graph, are
+ * rewritten whole. Finding the moved spheres is still a dense compare against
+ * the previous pose, as the library does not report what applyPose changed.
+ *
+ * Frames of a baked animation can be requested as well: they are copied from
+ * the mapped file instead of evaluated, and leave the live graph untouched.
+ */
+class GeometryWorker
+{
+public:
+	struct Frame {
+		std::optional<PoseKey> key;
+		std::vector<SM::Sphere> spheres;
+		SphereSoA soa;
+		BumperGeometry geometry;
+		bool hasGeometry = false;
+
+		// Pose generation held by spheres and soa, and by geometry; 0 for anything else
+		uint64_t sphereGeneration = 0;
+		uint64_t geometryGeneration = 0;
+
+		// Worker time spent on this frame, for the frame profiler
+		double poseMs = 0.0;
+		double buildMs = 0.0;
+	};
+
+	GeometryWorker(SM::Graph::BumperGraph* bumper_graph, BumperBuckets buckets, const GeometryCache* cache);
+	~GeometryWorker();
+
+	void setFrameReadyCallback(std::function<void()> callback);
+
+	void start();
+	void stop();
+
+	void requestPose(float alpha, float beta);
+	void requestBakedFrame(std::shared_ptr<const BakedAnimation> animation, size_t frame);
+	bool takeFrame(Frame &frame);
+
+private:
+	static constexpr uint64_t HISTORY_DEPTH = 8;
+
+	SM::Graph::BumperGraph* bg;
+	const GeometryCache* m_cache;
+	BumperGeometryBuilder m_builder;
+
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_running = false;
+
+	float m_pendingAlpha = 0.0f;
+	float m_pendingBeta = 0.0f;
+	bool m_hasRequest = false;
+
+	std::shared_ptr<const BakedAnimation> m_pendingAnimation;
+	size_t m_pendingFrame = 0;
+
+	// Everything below is only touched by the worker thread
+	float m_alpha = 0.0f;
+	float m_beta = 0.0f;
+
+	std::vector<SM::Sphere> m_spheres;
+	SphereDelta m_delta;
+
+	// Spheres changed by each of the last generations, slot generation % HISTORY_DEPTH
+	uint64_t m_generation = 0;
+	uint64_t m_firstGeneration = 0;
+	std::array<std::vector<uint32_t>, HISTORY_DEPTH> m_history;
+	std::vector<uint32_t> m_stale;
+
+	Frame m_back;
+	Frame m_ready;
+	bool m_readyValid = false;
+
+	std::function<void()> m_onFrameReady;
+
+	void run();
+	void evaluatePose(float alpha, float beta);
+	bool collectChangesSince(uint64_t generation);
+	void syncSpheres(Frame &frame);
+	void syncGeometry(Frame &frame);
+	void loadBakedFrame(const BakedAnimation &animation, size_t frame);
+};
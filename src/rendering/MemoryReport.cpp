@@ -0,0 +1,22 @@
+#include "MemoryReport.hpp"
+
+void MemoryReport::add(const QString &name, const size_t cpuBytes, const size_t gpuBytes)
+{
+    entries.push_back({ name, cpuBytes, gpuBytes });
+}
+
+size_t MemoryReport::totalCpuBytes() const
+{
+    size_t total = 0;
+    for (const auto &entry : entries)
+        total += entry.cpuBytes;
+    return total;
+}
+
+size_t MemoryReport::totalGpuBytes() const
+{
+    size_t total = 0;
+    for (const auto &entry : entries)
+        total += entry.gpuBytes;
+    return total;
+}
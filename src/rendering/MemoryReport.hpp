@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QString>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief CPU and GPU bytes held by each geometry buffer of the renderer.
+ */
+struct MemoryReport
+{
+	struct Entry {
+		QString name;
+		size_t cpuBytes;
+		size_t gpuBytes;
+	};
+
+	std::vector<Entry> entries;
+
+	void add(const QString &name, size_t cpuBytes, size_t gpuBytes);
+
+	size_t totalCpuBytes() const;
+	size_t totalGpuBytes() const;
+};
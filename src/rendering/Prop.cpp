@@ -0,0 +1,32 @@
+#include "Prop.hpp"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+void Prop::render(const Shader *shader)
+{
+    QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
+
+    shader->use();
+    shader->setMat4("model", transform);
+
+    mesh.vao.bind();
+    mesh.vbo.bind();
+
+    for (const auto &sub : mesh.subMeshes)
+    {
+        shader->setVec3("material.ambient",  sub.color);
+        shader->setVec3("material.diffuse",  sub.color);
+        shader->setVec3("material.specular", glm::vec3(0.1f, 0.1f, 0.1f));
+        shader->setFloat("material.shininess", 32.0f);
+
+        mesh.bindVertexAttributes(sub.baseVertex);
+
+        f->glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(sub.indexCount), mesh.indexType(sub),
+                          mesh.indexOffset(sub));
+    }
+
+    mesh.vbo.release();
+    mesh.vao.release();
+    shader->release();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QString>
+
+#include "BumperMesh.hpp"
+#include "Shader.hpp"
+#include "../geometry/TriangleBVH.hpp"
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief An imported triangle mesh placed in the scene around the characters.
+ *
+ * The mesh uses the bumper vertex layout and is drawn with the bumper shader
+ * under its own model matrix. Its TriangleBVH joins the crowd's instance BVH,
+ * so rays see props and characters in one traversal.
+ */
+struct Prop
+{
+	QString path;
+	glm::mat4 transform { 1.0f };
+	BumperMesh mesh;
+	TriangleBVH blas;
+
+	// Expects the renderer context to be current and the mesh uploaded
+	void render(const Shader *shader);
+};
@@ -1,12 +1,18 @@
 #include "Renderer.hpp"
 #include "Camera.hpp"
 
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QKeyEvent>
 
 #include "bumper_grid.h"
 #include "glm/gtc/type_ptr.hpp"
+#include "../core/ThreadPool.hpp"
+#include "../io/MeshExporter.hpp"
+#include "../io/MeshImporter.hpp"
 
 Renderer::Renderer(QWidget *parent)
     : QOpenGLWidget(parent),
@@ -26,9 +32,243 @@ Renderer::Renderer(QWidget *parent)
 
 Renderer::~Renderer()
 {
+    if (loadTask.valid())
+        loadTask.wait();
+    for (auto &task : propTasks)
+        task.wait();
+
+    delete geometryWorker;
+
+    if (bakeTask.valid())
+        bakeTask.wait();
+    delete poseEvaluator;
+
+    // Cached meshes own GL buffers
+    makeCurrent();
+    delete crowd;
+    props.clear();
+    readback.destroy();
+    profiler.destroy();
+    geometryCache.clear();
+    doneCurrent();
+
     delete camera;
 }
 
+void Renderer::setGeometryCacheBudget(const size_t bytes)
+{
+    makeCurrent();
+    geometryCache.setMemoryBudget(bytes);
+    doneCurrent();
+}
+
+void Renderer::setGeometryCacheQuantum(const float quantum)
+{
+    makeCurrent();
+    geometryCache.setQuantum(quantum);
+    doneCurrent();
+}
+
+void Renderer::setGeometryCacheEnabled(const bool enabled)
+{
+    makeCurrent();
+    geometryCache.setEnabled(enabled);
+    doneCurrent();
+}
+
+GeometryCache::Stats Renderer::geometryCacheStats() const
+{
+    return geometryCache.stats();
+}
+
+void Renderer::logGeometryCacheStats() const
+{
+    const auto stats = geometryCache.stats();
+    qDebug() << "Geometry cache:" << stats.entries << "entries,"
+             << stats.bytes / 1024 << "/" << geometryCache.memoryBudget() / 1024 << "KiB,"
+             << stats.hits << "hits," << stats.misses << "misses,"
+             << stats.evictions << "evictions";
+}
+
+MemoryReport Renderer::memoryReport() const
+{
+    MemoryReport report;
+    if (bgRenderer)
+        bgRenderer->reportMemory(report);
+
+    // Holds copies only, so nothing here is counted twice with the live mesh
+    const auto stats = geometryCache.stats();
+    report.add("geometry cache", stats.cpuBytes, stats.gpuBytes);
+
+    if (crowd)
+        crowd->reportMemory(report);
+
+    size_t propCpuBytes = 0, propGpuBytes = 0;
+    for (const auto &prop : props)
+    {
+        propCpuBytes += prop->mesh.cpuBytes() + prop->blas.bytes();
+        propGpuBytes += prop->mesh.gpuBytes();
+    }
+    if (!props.empty())
+        report.add("props", propCpuBytes, propGpuBytes);
+
+    return report;
+}
+
+void Renderer::logMemoryReport() const
+{
+    const MemoryReport report = memoryReport();
+    for (const auto &[name, cpuBytes, gpuBytes] : report.entries)
+        qDebug().noquote() << name << ":" << cpuBytes / 1024 << "KiB CPU,"
+                           << gpuBytes / 1024 << "KiB GPU";
+    qDebug() << "Total:" << report.totalCpuBytes() / 1024 << "KiB CPU,"
+             << report.totalGpuBytes() / 1024 << "KiB GPU";
+}
+
+bool Renderer::bakePoseGrid(const QString &path, const Pose &min, const Pose &max,
+                            const int alphaSteps, const int betaSteps)
+{
+    if (!poseEvaluator)
+        return false;
+
+    return BakedAnimation::bake(*poseEvaluator, BakedAnimation::grid(min, max, alphaSteps, betaSteps), path);
+}
+
+bool Renderer::loadBakedAnimation(const QString &path)
+{
+    if (!bgRenderer)
+        return false;
+
+    auto animation = std::make_shared<BakedAnimation>();
+    if (!animation->open(path))
+        return false;
+
+    if (animation->sphereCount() != bgRenderer->sphereSoA().size())
+    {
+        qDebug() << "Baked animation" << path << "does not match the loaded sphere mesh";
+        return false;
+    }
+
+    bakedAnimation = std::move(animation);
+    showBakedFrame(0);
+    return true;
+}
+
+void Renderer::showBakedFrame(const size_t frame)
+{
+    if (!bakedAnimation || bakedAnimation->frameCount() == 0)
+        return;
+
+    bakedFrame = std::min(frame, bakedAnimation->frameCount() - 1);
+    geometryWorker->requestBakedFrame(bakedAnimation, bakedFrame);
+}
+
+QString Renderer::defaultBakePath() const
+{
+    return QDir::temp().filePath(QFileInfo(meshPath).completeBaseName() + ".smbake");
+}
+
+void Renderer::bakeDefaultGrid()
+{
+    if (baking || !poseEvaluator)
+        return;
+
+    baking = true;
+    const QString path = defaultBakePath();
+    qDebug() << "Baking pose grid to" << path;
+
+    // The evaluator only reads its own graph copy, so it can run off the GUI thread
+    bakeTask = ThreadPool::global().submit([this, path] {
+        const bool ok = bakePoseGrid(path, { -10.0f, -10.0f }, { 10.0f, 10.0f }, 21, 21);
+        QMetaObject::invokeMethod(this, [this, ok, path] {
+            baking = false;
+            if (ok)
+                loadBakedAnimation(path);
+        }, Qt::QueuedConnection);
+    });
+}
+
+Timeline &Renderer::timeline()
+{
+    return m_timeline;
+}
+
+void Renderer::togglePlayback()
+{
+    if (m_timeline.isPlaying())
+    {
+        m_timeline.pause();
+        return;
+    }
+
+    if (m_timeline.keyframes().empty())
+    {
+        qDebug() << "Timeline has no keyframes, press K to add the current pose";
+        return;
+    }
+
+    m_timeline.resetStats();
+    m_timeline.play();
+    playbackClock.start();
+}
+
+void Renderer::addKeyframeAtCurrentPose()
+{
+    const auto &keys = m_timeline.keyframes();
+    const double time = keys.empty() ? 0.0 : keys.back().time + 1.0;
+    m_timeline.addKeyframe(time, { poseAlpha, poseBeta });
+    qDebug() << "Keyframe" << keys.size() << "at" << time << "s";
+}
+
+void Renderer::logTimelineStats() const
+{
+    const auto stats = m_timeline.stats();
+    qDebug() << "Timeline:" << stats.achievedFps << "/" << stats.targetFps << "fps,"
+             << stats.steps << "steps," << stats.droppedSteps << "dropped,"
+             << stats.presentedFrames << "presented";
+}
+
+void Renderer::setCrowd(std::vector<CrowdInstance> instances)
+{
+    if (!crowd)
+        return;
+
+    makeCurrent();
+    crowd->setInstances(std::move(instances));
+    doneCurrent();
+}
+
+void Renderer::setCrowdEnabled(const bool enabled)
+{
+    crowdEnabled = enabled;
+    update();
+}
+
+bool Renderer::isCrowdEnabled() const
+{
+    return crowdEnabled;
+}
+
+void Renderer::toggleCrowd()
+{
+    if (!crowd)
+        return;
+
+    if (!crowdEnabled && crowd->instances().empty())
+    {
+        // Space characters by the footprint of the loaded one
+        glm::vec3 min, max;
+        bgRenderer->sphereSoA().bounds(min, max);
+        const float spacing = 1.5f * std::max(max.x - min.x, max.z - min.z);
+
+        setCrowd(CrowdRenderer::grid(256, spacing, { -10.0f, -10.0f }, { 10.0f, 10.0f }, 16));
+    }
+
+    setCrowdEnabled(!crowdEnabled);
+    qDebug() << "Crowd" << (crowdEnabled ? "on:" : "off:") << crowd->instances().size() << "instances,"
+             << crowd->poseCount() << "poses";
+}
+
 void Renderer::useShader(const Shader* shdr) const
 {
     const float aspect = static_cast<float>(width()) / static_cast<float>(width());
@@ -59,25 +299,226 @@ void Renderer::initializeGL()
 
     glEnable(GL_DEPTH_TEST);
 
-    sm = new SM::SphereMesh();
-    bg = new SM::Graph::BumperGraph();
+    Shader::enableParallelCompilation();
 
-    sm->loadFromFile(smFilePath);
-    bg->constructFrom(*sm);
-    sm->inflate(-0.075f);
+    // The mesh VAOs expect positions at 0 and normals at 1
+    QElapsedTimer shaderClock;
+    shaderClock.start();
+    sphereShader = new Shader("shaders/impostor.vert", "shaders/impostor.frag", { { "aPos", 0 } });
+    bumperShader = new Shader("shaders/bumper.vert", "shaders/bumper.frag", { { "aPos", 0 }, { "aNormal", 1 } });
+    instancedBumperShader = new Shader("shaders/bumper_instanced.vert", "shaders/bumper.frag",
+                                       { { "aPos", 0 }, { "aNormal", 1 }, { "aModel", 2 } });
+    qDebug() << "Shaders ready in" << shaderClock.elapsed() << "ms";
 
-    sphereShader = new Shader("shaders/impostor.vert", "shaders/impostor.frag");
-    bumperShader = new Shader("shaders/bumper.vert", "shaders/bumper.frag");
+    // Frames are drawn empty until the mesh arrives
+    startLoading();
+    startPropImports();
+}
 
-    bgRenderer = new BumperGraphRenderer(bg);
+void Renderer::loadMesh(const QString &path)
+{
+    if (bg || loading)
+    {
+        qDebug() << "A sphere mesh is already loaded, ignoring" << path;
+        return;
+    }
+
+    meshPath = path;
+    if (isValid())
+        startLoading();
+}
+
+bool Renderer::isMeshLoaded() const
+{
+    return bgRenderer != nullptr;
+}
+
+void Renderer::startLoading()
+{
+    if (loading || bg)
+        return;
+
+    if (meshPath.isEmpty())
+    {
+        qDebug() << "No sphere mesh given, pass one on the command line or set mesh/path in the config";
+        return;
+    }
+
+    loading = true;
+    const QString path = meshPath;
+
+    loadTask = ThreadPool::global().submit([this, path] {
+        const auto asset = AssetLoader::load(path, [this](const QString &stage, const float progress) {
+            QMetaObject::invokeMethod(this, [this, stage, progress] {
+                emit loadingProgress(stage, progress);
+            }, Qt::QueuedConnection);
+        });
+
+        QMetaObject::invokeMethod(this, [this, asset] { onAssetLoaded(asset); }, Qt::QueuedConnection);
+    });
+}
+
+void Renderer::onAssetLoaded(const std::shared_ptr<AssetLoader::Asset> &asset)
+{
+    loading = false;
+    if (!asset->ok)
+    {
+        emit meshLoaded(false);
+        return;
+    }
+
+    makeCurrent();
+
+    sm = asset->sphereMesh.release();
+    bg = asset->graph.release();
+    posable = sm != nullptr;
+
+    bgRenderer = new BumperGraphRenderer(bg, asset->buckets, &asset->geometry);
     bgRenderer->setSphereShader(sphereShader);
     bgRenderer->setBumperShader(bumperShader);
+    bgRenderer->setGeometryCache(&geometryCache);
+    bgRenderer->setProfiler(&profiler);
+    if (const auto key = geometryCache.keyFor(poseAlpha, poseBeta))
+        bgRenderer->cacheSnapshot(*key);
 
     camera->setFocus(bgRenderer->getCentroid());
 
-    bumperShader->bindAttribute("aPos", 0);
-    bumperShader->bindAttribute("aNormal", 1);
-    sphereShader->bindAttribute("aPos", 0);
+    // Batch evaluation works on its own copy of the rest pose; binary meshes have no blend shapes
+    if (posable)
+    {
+        poseEvaluator = new PoseBatchEvaluator(*bg);
+        crowd = new CrowdRenderer(*bg, asset->buckets, geometryCache.quantum());
+        crowd->setRestSource(asset->path);
+        shareProps();
+    }
+
+    // From here on the worker thread is the only one touching bg
+    geometryWorker = new GeometryWorker(bg, std::move(asset->buckets), &geometryCache);
+    geometryWorker->setFrameReadyCallback([this] {
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+    });
+    geometryWorker->start();
+
+    doneCurrent();
+
+    emit meshLoaded(true);
+    update();
+}
+
+void Renderer::addProp(const QString &path, const glm::mat4 &transform)
+{
+    auto prop = std::make_shared<Prop>();
+    prop->path = path;
+    prop->transform = transform;
+    requestedProps.push_back(std::move(prop));
+
+    if (isValid())
+        startPropImports();
+}
+
+void Renderer::startPropImports()
+{
+    for (auto &prop : requestedProps)
+    {
+        // Importing and the BVH build touch no GL, the upload waits for the GUI thread
+        propTasks.push_back(ThreadPool::global().submit([this, prop] {
+            if (!MeshImporter::load(prop->path, prop->mesh))
+                return;
+            prop->blas.build(prop->mesh);
+
+            QMetaObject::invokeMethod(this, [this, prop] { onPropImported(prop); }, Qt::QueuedConnection);
+        }));
+    }
+    requestedProps.clear();
+}
+
+void Renderer::onPropImported(const std::shared_ptr<Prop> &prop)
+{
+    makeCurrent();
+    prop->mesh.upload();
+    props.push_back(prop);
+    shareProps();
+    doneCurrent();
+
+    update();
+}
+
+void Renderer::shareProps()
+{
+    if (!crowd)
+        return;
+
+    std::vector<const Prop*> shared;
+    shared.reserve(props.size());
+    for (const auto &prop : props)
+        shared.push_back(prop.get());
+    crowd->setProps(std::move(shared));
+}
+
+void Renderer::toggleRecording()
+{
+    if (recorder)
+    {
+        // The last frames of the ring are still on the GPU; stopping waits for the encoders anyway
+        makeCurrent();
+        readback.flush([this](QImage frame) { recorder->write(std::move(frame)); });
+        doneCurrent();
+
+        recorder->finish();
+        const auto stats = recorder->stats();
+        qDebug() << "Recorded" << stats.written << "frames to" << recorder->directory() << "(" << stats.failed
+                 << "failed," << stats.dropped << "dropped," << readback.stalls() << "readback stalls)";
+        recorder.reset();
+        return;
+    }
+
+    const QString name = QFileInfo(meshPath).completeBaseName();
+    recorder = std::make_unique<ImageSequenceWriter>(QDir::temp().filePath(name + "-frames"), name);
+    recorder->setFlipVertically(true);
+    qDebug() << "Recording frames to" << recorder->directory();
+}
+
+void Renderer::setFrameTimingsVisible(const bool visible)
+{
+    showFrameTimings = visible;
+    profiler.setEnabled(visible);
+    emit frameTimingsVisibilityChanged(visible);
+}
+
+bool Renderer::logFrameTimings(const QString &path)
+{
+    if (!profiler.setCsvLog(path))
+        return false;
+
+    qDebug() << "Logging frame timings to" << path;
+    return true;
+}
+
+void Renderer::exportCurrentPose() const
+{
+    if (!bgRenderer || !bgRenderer->mesh())
+        return;
+
+    // Written on the GUI thread: the mesh also owns GL buffers, which must not die on a worker
+    const QString name = QFileInfo(meshPath).completeBaseName();
+    const QString path = QDir::temp().filePath(name + "-pose.gltf");
+    MeshExporter exporter(path);
+    exporter.append(*bgRenderer->mesh(), name);
+    if (exporter.finish())
+        qDebug() << "Exported current pose to" << path;
+}
+
+void Renderer::captureFrame()
+{
+    const int w = static_cast<int>(static_cast<qreal>(width()) * devicePixelRatioF());
+    const int h = static_cast<int>(static_cast<qreal>(height()) * devicePixelRatioF());
+
+    // Frames arrive a few paints late from the PBO ring. Called from paintGL, so a frame the
+    // encoders have no slot for is dropped rather than waited for
+    readback.capture(w, h, [this](QImage frame) {
+        if (!recorder->tryWrite(std::move(frame)))
+            emit recordingFramesDropped(recorder->stats().dropped);
+    });
 }
 
 void Renderer::resizeGL(const int w, int h)
@@ -96,6 +537,24 @@ void Renderer::resizeGL(const int w, int h)
 
 void Renderer::paintGL()
 {
+    if (!bgRenderer)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        return;
+    }
+
+    profiler.beginFrame();
+    flushPendingPose();
+
+    if (geometryWorker->takeFrame(workerFrame))
+    {
+        profiler.addCpuTime(FrameProfiler::POSE, workerFrame.poseMs);
+        profiler.addCpuTime(FrameProfiler::BUILD, workerFrame.buildMs);
+        bgRenderer->present(workerFrame);
+        if (m_timeline.isPlaying())
+            m_timeline.framePresented();
+    }
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     const float aspect = static_cast<float>(width()) / static_cast<float>(height());
@@ -107,15 +566,47 @@ void Renderer::paintGL()
     glMatrixMode(GL_MODELVIEW);
     glLoadMatrixf(value_ptr(view));
 
-    useShader(sphereShader);
-    useShader(bumperShader);
-    bgRenderer->render();
+    if (crowdEnabled)
+    {
+        crowd->update();
+        useShader(bumperShader);
+        useShader(instancedBumperShader);
+        FrameProfiler::Scope scope(&profiler, FrameProfiler::BUMPERS);
+        crowd->render(bumperShader, instancedBumperShader);
+    }
+    else
+    {
+        useShader(sphereShader);
+        useShader(bumperShader);
+        bgRenderer->render();
+    }
+
+    for (const auto &prop : props)
+        prop->render(bumperShader);
+
+    if (recorder)
+        captureFrame();
+
+    profiler.endFrame();
+    if (showFrameTimings && profiler.frameCount() % TIMING_REFRESH_FRAMES == 0)
+        emit frameTimingsUpdated(profiler.summary());
 }
 
 void Renderer::updateScene()
 {
     if (freeze) return;
 
+    if (m_timeline.isPlaying())
+    {
+        const double elapsed = static_cast<double>(playbackClock.nsecsElapsed()) * 1e-9;
+        playbackClock.restart();
+
+        // The timeline yields absolute poses, the worker consumes deltas
+        Pose pose;
+        if (m_timeline.advance(elapsed, pose))
+            animate(pose.alpha - poseAlpha, pose.beta - poseBeta);
+    }
+
     update();
 }
 
@@ -155,7 +646,6 @@ void Renderer::mouseMoveEvent(QMouseEvent *event)
     {
         const float factor = 0.5f;
         animate(delta.x() * factor, delta.y() * factor);
-        update();
     }
 
     event->accept();
@@ -176,12 +666,31 @@ void Renderer::wheelEvent(QWheelEvent *event)
 
 void Renderer::animate(const float alpha, const float beta)
 {
-    bg->setPose(alpha, beta);
-    bg->applyPose();
-    bgRenderer->update();
+    if (!posable)
+        return;
+
+    poseAlpha += alpha;
+    poseBeta += beta;
+
+    pendingAlpha += alpha;
+    pendingBeta += beta;
+    posePending = true;
+
+    // Qt merges repeated update() calls into a single paint
     update();
 }
 
+void Renderer::flushPendingPose()
+{
+    if (!posePending)
+        return;
+
+    geometryWorker->requestPose(pendingAlpha, pendingBeta);
+    pendingAlpha = 0.0f;
+    pendingBeta = 0.0f;
+    posePending = false;
+}
+
 void Renderer::keyPressEvent(QKeyEvent *event)
 {
     if (event->key() == Qt::Key_Escape)
@@ -191,8 +700,24 @@ void Renderer::keyPressEvent(QKeyEvent *event)
     else if (event->key() == Qt::Key_F)
     {
         freeze = !freeze;
+
+        // The frozen interval is a pause, not time for the timeline to catch up on
+        if (!freeze)
+            playbackClock.restart();
         update();
     }
+    else if (event->key() == Qt::Key_C) logGeometryCacheStats();
+    else if (event->key() == Qt::Key_M) logMemoryReport();
+    else if (event->key() == Qt::Key_B) bakeDefaultGrid();
+    else if (event->key() == Qt::Key_P) togglePlayback();
+    else if (event->key() == Qt::Key_K) addKeyframeAtCurrentPose();
+    else if (event->key() == Qt::Key_T) logTimelineStats();
+    else if (event->key() == Qt::Key_G) toggleCrowd();
+    else if (event->key() == Qt::Key_R) toggleRecording();
+    else if (event->key() == Qt::Key_E) exportCurrentPose();
+    else if (event->key() == Qt::Key_H) setFrameTimingsVisible(!showFrameTimings);
+    else if (event->key() == Qt::Key_BracketRight) showBakedFrame(bakedFrame + 1);
+    else if (event->key() == Qt::Key_BracketLeft && bakedFrame > 0) showBakedFrame(bakedFrame - 1);
     else if (event->key() == Qt::Key_Right) animate(0.5f, 0.0f);
     else if (event->key() == Qt::Key_Left) animate(-0.5f, 0.0f);
     else if (event->key() == Qt::Key_Down) animate(0.0f, 0.5f);
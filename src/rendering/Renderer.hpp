@@ -3,11 +3,24 @@
 #include <QMatrix4x4>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions>
+#include <QElapsedTimer>
 #include <QTimer>
 
 #include "BumperGraphRenderer.hpp"
 #include "bumper_graph.h"
 #include "bumper_grid.h"
+#include "CrowdRenderer.hpp"
+#include "FrameProfiler.hpp"
+#include "FrameReadback.hpp"
+#include "GeometryCache.hpp"
+#include "GeometryWorker.hpp"
+#include "MemoryReport.hpp"
+#include "Prop.hpp"
+#include "../animation/BakedAnimation.hpp"
+#include "../animation/PoseBatchEvaluator.hpp"
+#include "../animation/Timeline.hpp"
+#include "../io/AssetLoader.hpp"
+#include "../io/ImageSequenceWriter.hpp"
 #include "Shader.hpp"
 #include "sphere_mesh.h"
 
@@ -20,8 +33,45 @@ public:
 	explicit Renderer(QWidget *parent = nullptr);
 	~Renderer() override;
 
+	// Loading starts once the GL context exists; only the first mesh is taken
+	void loadMesh(const QString &path);
+	bool isMeshLoaded() const;
+
+	// Deltas are accumulated and handed to the worker once per painted frame
 	void animate(float alpha, float beta);
 
+	void setGeometryCacheBudget(size_t bytes);
+	void setGeometryCacheQuantum(float quantum);
+	void setGeometryCacheEnabled(bool enabled);
+	GeometryCache::Stats geometryCacheStats() const;
+
+	MemoryReport memoryReport() const;
+
+	bool bakePoseGrid(const QString &path, const Pose &min, const Pose &max, int alphaSteps, int betaSteps);
+	bool loadBakedAnimation(const QString &path);
+	void showBakedFrame(size_t frame);
+
+	Timeline &timeline();
+	void togglePlayback();
+
+	// Imported off the GUI thread like the mesh; props show up as they finish
+	void addProp(const QString &path, const glm::mat4 &transform = glm::mat4(1.0f));
+
+	void setCrowd(std::vector<CrowdInstance> instances);
+	void setCrowdEnabled(bool enabled);
+	bool isCrowdEnabled() const;
+
+	// Per-stage timings: shown through frameTimingsUpdated, or written one CSV row per frame
+	void setFrameTimingsVisible(bool visible);
+	bool logFrameTimings(const QString &path);
+
+signals:
+	void loadingProgress(const QString &stage, float progress);
+	void meshLoaded(bool ok);
+	void frameTimingsUpdated(const QString &summary);
+	void frameTimingsVisibilityChanged(bool visible);
+	void recordingFramesDropped(size_t dropped);
+
 protected:
 	void initializeGL() override;
 	void resizeGL(int w, int h) override;
@@ -46,15 +96,66 @@ private:
 
 	Shader* sphereShader{};
 	Shader* bumperShader{};
+	Shader* instancedBumperShader{};
+
+	GeometryCache geometryCache;
+	GeometryWorker* geometryWorker {};
+	GeometryWorker::Frame workerFrame;
+
+	PoseBatchEvaluator* poseEvaluator {};
+	std::shared_ptr<BakedAnimation> bakedAnimation;
+	size_t bakedFrame = 0;
+	bool baking = false;
+	std::future<void> bakeTask;
+
+	CrowdRenderer* crowd {};
+	bool crowdEnabled = false;
+
+	std::vector<std::shared_ptr<Prop>> props;
+	std::vector<std::shared_ptr<Prop>> requestedProps;
+	std::vector<std::future<void>> propTasks;
+
+	std::unique_ptr<ImageSequenceWriter> recorder;
+	FrameReadback readback;
+
+	static constexpr uint64_t TIMING_REFRESH_FRAMES = 15;
+	FrameProfiler profiler;
+	bool showFrameTimings = false;
+
+	Timeline m_timeline;
+	QElapsedTimer playbackClock;
+	float poseAlpha = 0.0f;
+	float poseBeta = 0.0f;
+	float pendingAlpha = 0.0f;
+	float pendingBeta = 0.0f;
+	bool posePending = false;
 
 	bool m_leftButtonPressed;
 	bool m_rightButtonPressed;
 	QPoint m_lastMousePos;
 
-	// TODO: Change this path
-	const char* smFilePath = "/Users/davidepaollilo/Desktop/Workspace/C++/SMClothPhysicsSim/assets/gorillaAnim.sm";
+	QString meshPath;
+	std::future<void> loadTask;
+	bool loading = false;
+	bool posable = false;
 
 	bool freeze = false;
 
 	void useShader(const Shader* shdr) const;
+	void startLoading();
+	void onAssetLoaded(const std::shared_ptr<AssetLoader::Asset> &asset);
+	void flushPendingPose();
+	void logGeometryCacheStats() const;
+	void logMemoryReport() const;
+	void bakeDefaultGrid();
+	QString defaultBakePath() const;
+	void addKeyframeAtCurrentPose();
+	void logTimelineStats() const;
+	void toggleCrowd();
+	void startPropImports();
+	void onPropImported(const std::shared_ptr<Prop> &prop);
+	void shareProps();
+	void toggleRecording();
+	void captureFrame();
+	void exportCurrentPose() const;
 };
\ No newline at end of file
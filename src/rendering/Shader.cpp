@@ -2,10 +2,13 @@
 #include <QCoreApplication>
 #include <QDir>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
 
-Shader::Shader(const QString &vertexPath, const QString &fragmentPath) : m_program(new QOpenGLShaderProgram)
+Shader::Shader(const QString &vertexPath, const QString &fragmentPath, const AttributeBindings &attributes)
+    : m_program(new QOpenGLShaderProgram)
 {
-    if (!load(vertexPath, fragmentPath)) qDebug() << "Shaders not loaded correctly!";
+    if (!load(vertexPath, fragmentPath, attributes)) qDebug() << "Shaders not loaded correctly!";
 }
 
 Shader::~Shader()
@@ -20,32 +23,64 @@ QString Shader::resolvePath(const QString &relativePath)
     return dir.absoluteFilePath(relativePath);
 }
 
-bool Shader::load(const QString &vertexPath, const QString &fragmentPath) const
+bool Shader::load(const QString &vertexPath, const QString &fragmentPath, const AttributeBindings &attributes) const
 {
     const QString vertexFullPath = resolvePath(vertexPath);
     const QString fragmentFullPath = resolvePath(fragmentPath);
 
-    if (!m_program->addShaderFromSourceFile(QOpenGLShader::Vertex, vertexFullPath))
+    // Cacheable shaders are only read here; compiling is left to link(), which skips it on a cache hit
+    if (!m_program->addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, vertexFullPath))
     {
-        qDebug() << "Vertex shader compile error:" << m_program->log();
+        qDebug() << "Cannot read vertex shader:" << vertexFullPath;
         return false;
     }
 
-    if (!m_program->addShaderFromSourceFile(QOpenGLShader::Fragment, fragmentFullPath))
+    if (!m_program->addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, fragmentFullPath))
     {
-        qDebug() << "Fragment shader compile error:" << m_program->log();
+        qDebug() << "Cannot read fragment shader:" << fragmentFullPath;
         return false;
     }
 
+    for (const auto &[name, location] : attributes)
+        m_program->bindAttributeLocation(name.c_str(), static_cast<int>(location));
+
+    QElapsedTimer clock;
+    clock.start();
+
     if (!m_program->link())
     {
-        qDebug() << "Shader link error:" << m_program->log();
+        qDebug() << "Shader compile or link error:" << m_program->log();
         return false;
     }
 
+    qDebug() << "Shader" << vertexPath << "+" << fragmentPath << "ready in"
+             << static_cast<double>(clock.nsecsElapsed()) * 1e-6 << "ms";
     return true;
 }
 
+void Shader::enableParallelCompilation()
+{
+    using MaxShaderCompilerThreads = void (QOPENGLF_APIENTRYP)(GLuint count);
+
+    const QOpenGLContext *context = QOpenGLContext::currentContext();
+    MaxShaderCompilerThreads maxShaderCompilerThreads = nullptr;
+    if (context->hasExtension("GL_KHR_parallel_shader_compile"))
+        maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreads>(
+            context->getProcAddress("glMaxShaderCompilerThreadsKHR"));
+    else if (context->hasExtension("GL_ARB_parallel_shader_compile"))
+        maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreads>(
+            context->getProcAddress("glMaxShaderCompilerThreadsARB"));
+
+    if (!maxShaderCompilerThreads)
+    {
+        qDebug() << "Parallel shader compilation unavailable";
+        return;
+    }
+
+    // 0xFFFFFFFF leaves the thread count to the driver
+    maxShaderCompilerThreads(0xFFFFFFFFu);
+}
+
 void Shader::bindAttribute(const std::string& name, const unsigned int location) const
 {
     if (m_program)
@@ -3,16 +3,27 @@
 #include <QOpenGLShaderProgram>
 #include <QString>
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "glm/glm.hpp"
 
 /**
  * @brief The Shader class wraps QOpenGLShaderProgram and provides a convenient
  *        interface to load shaders from files using relative paths.
+ *
+ * Sources are added as cacheable, so Qt links from a program binary stored
+ * under QStandardPaths::CacheLocation when one matches the sources and the
+ * driver, and compiles only on a miss. Attribute locations are part of the
+ * binary and have to be given to the constructor, before the link.
  */
 class Shader
 {
 public:
-	Shader(const QString &vertexPath, const QString &fragmentPath);
+	using AttributeBindings = std::vector<std::pair<std::string, unsigned int>>;
+
+	Shader(const QString &vertexPath, const QString &fragmentPath, const AttributeBindings &attributes = {});
 	~Shader();
 
 	void use() const;
@@ -27,10 +38,13 @@ public:
 
 	QOpenGLShaderProgram* program() const;
 
+	// Lets the driver compile on its own threads; call once with the context current
+	static void enableParallelCompilation();
+
 private:
 	QOpenGLShaderProgram *m_program;
 
-	bool load(const QString &vertexPath, const QString &fragmentPath) const;
+	bool load(const QString &vertexPath, const QString &fragmentPath, const AttributeBindings &attributes) const;
 
 	static QString resolvePath(const QString &relativePath);
 };
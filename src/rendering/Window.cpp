@@ -1,15 +1,68 @@
 #include "Window.hpp"
 #include "Renderer.hpp"
 
-Window::Window(QWidget *parent)
+#include <QFileInfo>
+#include <QFontDatabase>
+#include <QLabel>
+#include <QStatusBar>
+
+Window::Window(const QString &meshPath, const QStringList &propPaths, QWidget *parent)
     : QMainWindow(parent)
 {
     renderer = new Renderer(this);
     setCentralWidget(renderer);
     setWindowTitle("SM RT Renderer");
     resize(800, 600);
+
+    connect(renderer, &Renderer::loadingProgress, this, [this](const QString &stage, const float progress) {
+        statusBar()->showMessage(QString("%1... %2%").arg(stage).arg(qRound(progress * 100.0f)));
+    });
+    connect(renderer, &Renderer::meshLoaded, this, [this, meshPath](const bool ok) {
+        const QString name = QFileInfo(meshPath).fileName();
+        if (ok)
+        {
+            setWindowTitle("SM RT Renderer - " + name);
+            statusBar()->showMessage("Loaded " + name, 3000);
+        }
+        else
+            statusBar()->showMessage("Could not load " + meshPath);
+    });
+
+    // Drawn over the GL view, top left, while H is toggled on
+    timingOverlay = new QLabel(renderer);
+    timingOverlay->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    timingOverlay->setStyleSheet("QLabel { background: rgba(0, 0, 0, 160); color: white; padding: 6px; }");
+    timingOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    timingOverlay->move(8, 8);
+    timingOverlay->setText("Measuring...");
+    timingOverlay->adjustSize();
+    timingOverlay->hide();
+
+    connect(renderer, &Renderer::frameTimingsVisibilityChanged, timingOverlay, &QLabel::setVisible);
+    connect(renderer, &Renderer::frameTimingsUpdated, this, [this](const QString &summary) {
+        timingOverlay->setText(summary);
+        timingOverlay->adjustSize();
+    });
+
+    connect(renderer, &Renderer::recordingFramesDropped, this, [this](const size_t dropped) {
+        statusBar()->showMessage(QString("Recording: %1 frames dropped, the encoders are behind")
+                                     .arg(static_cast<qulonglong>(dropped)), 2000);
+    });
+
+    if (!meshPath.isEmpty())
+        renderer->loadMesh(meshPath);
+    else
+        statusBar()->showMessage("No sphere mesh given");
+
+    for (const QString &path : propPaths)
+        renderer->addProp(path);
 }
 
 Window::~Window()
 {
 }
+
+bool Window::logFrameTimings(const QString &csvPath)
+{
+    return renderer->logFrameTimings(csvPath);
+}
@@ -1,16 +1,23 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QStringList>
 
+class QLabel;
 class Renderer;
 
 class Window final : public QMainWindow
 {
 	Q_OBJECT
 public:
-	explicit Window(QWidget *parent = nullptr);
+	explicit Window(const QString &meshPath = QString(), const QStringList &propPaths = {},
+					QWidget *parent = nullptr);
 	~Window() override;
 
+	// Appends one row of per-stage timings per frame; H toggles the on-screen overlay
+	bool logFrameTimings(const QString &csvPath);
+
 private:
 	Renderer *renderer;
+	QLabel *timingOverlay;
 };
\ No newline at end of file
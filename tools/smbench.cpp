@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bumper_graph.h"
+#include "sphere_mesh.h"
+#include "../src/animation/PoseBatchEvaluator.hpp"
+#include "../src/geometry/BumperGeometryBuilder.hpp"
+#include "../src/geometry/SyntheticGraph.hpp"
+
+// Times the CPU hot paths of the viewer on the sphere meshes given on the
+// command line, or on synthetic graphs of the sizes given with -n: loading,
+// graph construction, posing and tessellation. Every benchmark runs a warm-up
+// and then a number of timed repetitions, reporting the median, minimum and
+// spread per operation, the heap allocations per operation and the
+// throughput. No GL context is needed.
+
+namespace
+{
+	// Counted by the replaced global operator new below
+	std::atomic<size_t> allocationCount { 0 };
+	std::atomic<size_t> allocationBytes { 0 };
+
+	void *allocate(size_t size, const size_t alignment)
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocationBytes.fetch_add(size, std::memory_order_relaxed);
+
+		if (size == 0)
+			size = 1;
+
+		void *p = alignment > alignof(std::max_align_t)
+			? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+			: std::malloc(size);
+		if (!p)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	// Keeps results observable so the optimizer cannot drop the measured work
+	volatile float sink;
+
+	struct Benchmark
+	{
+		std::string name;
+		size_t opsPerRepetition;
+		double itemsPerOp;
+		const char *unit;
+	};
+
+	struct Counters
+	{
+		size_t allocations;
+		size_t bytes;
+
+		static Counters now()
+		{
+			return { allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed) };
+		}
+	};
+
+	int repetitions = 10;
+
+	template <typename Body>
+	void run(const Benchmark &benchmark, Body &&body)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// Warm-up: first touch of the output buffers and the caches
+		for (size_t op = 0; op < benchmark.opsPerRepetition; op++)
+			body(op);
+
+		std::vector<double> nsPerOp;
+		nsPerOp.reserve(repetitions);
+
+		const Counters before = Counters::now();
+		for (int r = 0; r < repetitions; r++)
+		{
+			const auto start = Clock::now();
+			for (size_t op = 0; op < benchmark.opsPerRepetition; op++)
+				body(op);
+			const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			nsPerOp.push_back(elapsed / static_cast<double>(benchmark.opsPerRepetition));
+		}
+		const Counters after = Counters::now();
+
+		const double ops = static_cast<double>(benchmark.opsPerRepetition) * repetitions;
+		const double allocations = static_cast<double>(after.allocations - before.allocations) / ops;
+		const double bytes = static_cast<double>(after.bytes - before.bytes) / ops;
+
+		double mean = 0.0;
+		for (const double ns : nsPerOp)
+			mean += ns;
+		mean /= static_cast<double>(nsPerOp.size());
+
+		double variance = 0.0;
+		for (const double ns : nsPerOp)
+			variance += (ns - mean) * (ns - mean);
+		const double spread = nsPerOp.size() > 1 ? std::sqrt(variance / static_cast<double>(nsPerOp.size() - 1)) : 0.0;
+
+		std::vector<double> sorted = nsPerOp;
+		std::sort(sorted.begin(), sorted.end());
+		const double median = sorted[sorted.size() / 2];
+		const double throughput = benchmark.itemsPerOp * 1e9 / median;
+
+		std::printf("  %-26s %14.0f %14.0f %6.1f%% %10.1f %12.0f %12.3g %s/s\n",
+					benchmark.name.c_str(), median, sorted.front(), mean > 0.0 ? 100.0 * spread / mean : 0.0,
+					allocations, bytes, throughput, benchmark.unit);
+	}
+
+	void printHeader(const std::string &name, const SM::Graph::BumperGraph &bg, const BumperBuckets &buckets)
+	{
+		std::printf("\n%s: %zu spheres, %zu bumpers (%zu prysmoids, %zu quads, %zu capsuloids)\n", name.c_str(),
+					bg.sphere.size(), buckets.size(), buckets.prysmoids.size(), buckets.quads.size(),
+					buckets.capsuloids.size());
+		std::printf("  %-26s %14s %14s %7s %10s %12s %12s\n", "benchmark", "median ns/op", "min ns/op", "spread",
+					"allocs/op", "bytes/op", "throughput");
+	}
+
+	void benchmarkGraph(const SM::Graph::BumperGraph &bg, const BumperBuckets &buckets, const bool posable)
+	{
+		const size_t spheres = bg.sphere.size();
+
+		if (posable)
+		{
+			// Alternates between two poses so every applyPose has spheres to move
+			SM::Graph::BumperGraph posed = bg;
+			run({ "setPose + applyPose", 16, static_cast<double>(spheres), "spheres" }, [&](const size_t op) {
+				const float t = (op & 1) ? 1.0f : -1.0f;
+				posed.setPose(5.0f * t, -5.0f * t);
+				posed.applyPose();
+			});
+
+			// What PoseBatchEvaluator pays per pose before applying it
+			SM::Graph::BumperGraph scratch = bg;
+			run({ "graph reset", 16, static_cast<double>(spheres), "spheres" }, [&](size_t) {
+				scratch = bg;
+			});
+		}
+
+		BumperGeometryBuilder builder(BumperBuckets { buckets });
+		BumperGeometry geometry;
+		builder.build(bg.sphere, geometry);
+		const double triangles = static_cast<double>(geometry.indexCount()) / 3.0;
+
+		// The CPU side of BumperGraphRenderer::update, into a reused buffer like the renderer
+		run({ "BumperGeometryBuilder::build", 4, triangles, "triangles" }, [&](size_t) {
+			builder.build(bg.sphere, geometry);
+		});
+
+		// buildCapsuleBetweenSpheres is private: a builder holding only the capsuloids does little else
+		if (!buckets.capsuloids.empty())
+		{
+			BumperGeometryBuilder capsules(BumperBuckets { {}, {}, buckets.capsuloids });
+			BumperGeometry capsuleGeometry;
+			run({ "capsules between spheres", 4, static_cast<double>(buckets.capsuloids.size()), "capsules" },
+				[&](size_t) { capsules.build(bg.sphere, capsuleGeometry); });
+		}
+
+		if (!buckets.prysmoids.empty())
+		{
+			run({ "computeUpperPlaneNormal", 1, static_cast<double>(buckets.prysmoids.size()), "normals" },
+				[&](size_t) {
+				float sum = 0.0f;
+				for (const auto &bp : buckets.prysmoids)
+				{
+					const glm::vec3 n = BumperGeometryBuilder::computeUpperPlaneNormal(
+						bg.sphere[bp.sphereIndex[0]], bg.sphere[bp.sphereIndex[1]], bg.sphere[bp.sphereIndex[2]], 1);
+					sum += n.x + n.y + n.z;
+				}
+				sink = sum;
+			});
+		}
+
+		if (!posable)
+			return;
+
+		PoseBatchEvaluator evaluator(bg);
+		std::vector<Pose> poses(64);
+		for (size_t i = 0; i < poses.size(); i++)
+			poses[i] = { -10.0f + 20.0f * static_cast<float>(i) / 63.0f, 0.0f };
+		std::vector<SphereSoA> evaluated;
+		run({ "PoseBatchEvaluator (64)", 1, static_cast<double>(poses.size()), "poses" }, [&](size_t) {
+			evaluator.evaluate(poses, evaluated);
+		});
+	}
+
+	void benchmarkMesh(const char *path)
+	{
+		SM::SphereMesh sm;
+		sm.loadFromFile(path);
+
+		SM::Graph::BumperGraph bg;
+		bg.constructFrom(sm);
+
+		const size_t spheres = bg.sphere.size();
+		if (spheres == 0)
+		{
+			std::fprintf(stderr, "%s: no spheres, skipped\n", path);
+			return;
+		}
+
+		const BumperBuckets buckets = BumperBuckets::from(bg);
+		printHeader(path, bg, buckets);
+
+		run({ "SphereMesh::loadFromFile", 1, static_cast<double>(spheres), "spheres" }, [&](size_t) {
+			SM::SphereMesh loaded;
+			loaded.loadFromFile(path);
+		});
+
+		run({ "BumperGraph::constructFrom", 1, static_cast<double>(spheres), "spheres" }, [&](size_t) {
+			SM::Graph::BumperGraph constructed;
+			constructed.constructFrom(sm);
+		});
+
+		benchmarkGraph(bg, buckets, true);
+	}
+
+	// Synthetic graphs have no blend shapes, so only the geometry paths are timed
+	void benchmarkSynthetic(const size_t count)
+	{
+		SyntheticGraph::Parameters parameters;
+		parameters.sphereCount = count;
+
+		SM::Graph::BumperGraph bg;
+		SyntheticGraph::generate(parameters, bg);
+
+		const BumperBuckets buckets = BumperBuckets::from(bg);
+		printHeader("synthetic " + std::to_string(count), bg, buckets);
+		benchmarkGraph(bg, buckets, false);
+	}
+}
+
+void *operator new(const size_t size)
+{
+	return allocate(size, 0);
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment)
+{
+	return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<const char*> paths;
+	std::vector<size_t> syntheticCounts;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			repetitions = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			syntheticCounts.push_back(std::strtoull(argv[++i], nullptr, 10));
+		else
+			paths.push_back(argv[i]);
+	}
+
+	if (paths.empty() && syntheticCounts.empty())
+	{
+		std::fprintf(stderr, "usage: %s [-r repetitions] [-n synthetic sphere count]... [mesh.sm]...\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%d repetitions, %u threads\n", repetitions, std::max(1u, std::thread::hardware_concurrency()));
+	for (const char *path : paths)
+		benchmarkMesh(path);
+	for (const size_t count : syntheticCounts)
+		benchmarkSynthetic(count);
+
+	return 0;
+}
@@ -0,0 +1,35 @@
+#include <QString>
+
+#include <cstdio>
+
+#include "bumper_graph.h"
+#include "sphere_mesh.h"
+#include "../src/io/SphereMeshFile.hpp"
+
+// Converts a text sphere mesh (.sm) into the memory-mappable .smb format
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "usage: %s <input.sm> <output.smb>\n", argv[0]);
+		return 1;
+	}
+
+	SM::SphereMesh sm;
+	SM::Graph::BumperGraph bg;
+
+	sm.loadFromFile(argv[1]);
+	bg.constructFrom(sm);
+
+	if (bg.sphere.empty())
+	{
+		std::fprintf(stderr, "%s: no spheres loaded from %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	if (!SphereMeshFile::write(bg, QString::fromLocal8Bit(argv[2])))
+		return 1;
+
+	std::printf("%zu spheres, %zu bumpers written to %s\n", bg.sphere.size(), bg.bumper.size(), argv[2]);
+	return 0;
+}
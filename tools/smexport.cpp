@@ -0,0 +1,94 @@
+#include <QFileInfo>
+#include <QString>
+
+#include <cstdio>
+#include <vector>
+
+#include "bumper_graph.h"
+#include "sphere_mesh.h"
+#include "../src/animation/BakedAnimation.hpp"
+#include "../src/geometry/BumperGeometryBuilder.hpp"
+#include "../src/geometry/SphereSoA.hpp"
+#include "../src/io/MeshExporter.hpp"
+#include "../src/io/SphereMeshFile.hpp"
+
+// Exports the tessellated bumpers of a sphere mesh to OBJ or glTF, either the
+// rest pose or every frame of a baked animation. Frames are tessellated into
+// one reused buffer and streamed out, so memory stays at a single pose.
+int main(int argc, char *argv[])
+{
+	if (argc != 3 && argc != 4)
+	{
+		std::fprintf(stderr, "usage: %s <input.sm|input.smb> <output.obj|output.gltf> [animation.smbake]\n", argv[0]);
+		return 1;
+	}
+
+	const QString input = QString::fromLocal8Bit(argv[1]);
+	const QString output = QString::fromLocal8Bit(argv[2]);
+
+	if (!MeshExporter::supports(output))
+	{
+		std::fprintf(stderr, "%s: %s is neither .obj nor .gltf\n", argv[0], argv[2]);
+		return 1;
+	}
+
+	SM::Graph::BumperGraph bg;
+	if (QFileInfo(input).suffix() == "smb")
+	{
+		if (!SphereMeshFile::read(input, bg))
+			return 1;
+	}
+	else
+	{
+		SM::SphereMesh sm;
+		sm.loadFromFile(argv[1]);
+		bg.constructFrom(sm);
+	}
+
+	if (bg.sphere.empty())
+	{
+		std::fprintf(stderr, "%s: no spheres loaded from %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	BumperGeometryBuilder builder(BumperBuckets::from(bg));
+	BumperGeometry geometry;
+	MeshExporter exporter(output);
+	if (!exporter.isOpen())
+		return 1;
+
+	if (argc == 3)
+	{
+		builder.build(bg.sphere, geometry);
+		exporter.append(geometry, QFileInfo(input).completeBaseName());
+	}
+	else
+	{
+		BakedAnimation animation;
+		if (!animation.open(QString::fromLocal8Bit(argv[3])))
+			return 1;
+
+		if (animation.sphereCount() != bg.sphere.size())
+		{
+			std::fprintf(stderr, "%s: %s was baked for %zu spheres, the mesh has %zu\n", argv[0], argv[3],
+						 animation.sphereCount(), bg.sphere.size());
+			return 1;
+		}
+
+		std::vector<SM::Sphere> spheres;
+		SphereSoA soa;
+		for (size_t frame = 0; frame < animation.frameCount(); frame++)
+		{
+			animation.copyFrame(frame, spheres, soa);
+			builder.build(spheres, geometry);
+			if (!exporter.append(geometry, QString("frame_%1").arg(static_cast<qulonglong>(frame), 5, 10, QChar('0'))))
+				return 1;
+		}
+	}
+
+	if (!exporter.finish())
+		return 1;
+
+	std::printf("%zu poses written to %s\n", exporter.poseCount(), argv[2]);
+	return 0;
+}
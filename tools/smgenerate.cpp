@@ -0,0 +1,61 @@
+#include <QString>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bumper_graph.h"
+#include "../src/geometry/SyntheticGraph.hpp"
+#include "../src/io/SphereMeshFile.hpp"
+
+// Writes a synthetic bumper graph as .smb, for scaling tests at sizes no
+// hand-made mesh reaches. The same arguments always produce the same file.
+int main(int argc, char *argv[])
+{
+	SyntheticGraph::Parameters parameters;
+	const char *output = nullptr;
+	bool countSet = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+		{
+			parameters.seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+		{
+			auto &mix = parameters.mix;
+			if (std::sscanf(argv[++i], "%f,%f,%f", &mix.quads, &mix.prysmoids, &mix.capsuloids) != 3 ||
+				!mix.isValid())
+			{
+				std::fprintf(stderr, "%s: -m expects non-negative quads,prysmoids,capsuloids weights\n", argv[0]);
+				return 1;
+			}
+		}
+		else if (!countSet)
+		{
+			parameters.sphereCount = std::strtoull(argv[i], nullptr, 10);
+			countSet = true;
+		}
+		else
+		{
+			output = argv[i];
+		}
+	}
+
+	if (!countSet || !output || parameters.sphereCount == 0)
+	{
+		std::fprintf(stderr, "usage: %s [-s seed] [-m quads,prysmoids,capsuloids] <sphere count> <output.smb>\n",
+					 argv[0]);
+		return 1;
+	}
+
+	SM::Graph::BumperGraph bg;
+	SyntheticGraph::generate(parameters, bg);
+
+	if (!SphereMeshFile::write(bg, QString::fromLocal8Bit(output)))
+		return 1;
+
+	std::printf("%zu spheres, %zu bumpers written to %s\n", bg.sphere.size(), bg.bumper.size(), output);
+	return 0;
+}